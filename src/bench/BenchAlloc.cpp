@@ -0,0 +1,89 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * BenchAlloc.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "BenchAlloc.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#ifdef __GLIBC__
+
+//The allocation functions are interposed to count heap allocations of the
+//whole process, including those of OpenCV. They forward to the allocator of
+//the C library. Every call pays an atomic add, so only tld_bench links this.
+extern "C"
+{
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+static uint64_t heapAllocations = 0;
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    __sync_fetch_and_add(&heapAllocations, 1);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) __THROW
+{
+    __sync_fetch_and_add(&heapAllocations, 1);
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) __THROW
+{
+    __sync_fetch_and_add(&heapAllocations, 1);
+    return __libc_realloc(p, size);
+}
+
+extern "C" int posix_memalign(void **p, size_t alignment, size_t size) __THROW
+{
+    if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+
+    __sync_fetch_and_add(&heapAllocations, 1);
+    *p = __libc_memalign(alignment, size);
+    return (*p != NULL) ? 0 : ENOMEM;
+}
+
+#endif
+
+namespace tld
+{
+
+uint64_t benchHeapAllocations()
+{
+#ifdef __GLIBC__
+    return __sync_fetch_and_add(&heapAllocations, 0);
+#else
+    return 0;
+#endif
+}
+
+} /* namespace tld */
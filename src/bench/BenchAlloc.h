@@ -0,0 +1,38 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * BenchAlloc.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef BENCHALLOC_H_
+#define BENCHALLOC_H_
+
+#include <stdint.h>
+
+namespace tld
+{
+
+//Calls of malloc, calloc, realloc and posix_memalign so far (glibc), 0 elsewhere.
+//Linking BenchAlloc.cpp replaces the allocation functions of the process.
+uint64_t benchHeapAllocations();
+
+} /* namespace tld */
+#endif /* BENCHALLOC_H_ */
@@ -0,0 +1,271 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * BenchUtil.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "BenchUtil.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/resource.h>
+#include <time.h>
+
+using namespace cv;
+using namespace std;
+
+namespace tld
+{
+
+const SyntheticScenario benchScenarios[] =
+{
+    {"moving", false, false, false},
+    {"clutter", true, false, false},
+    {"occlusion", false, true, false},
+    {"scale", false, false, true}
+};
+
+const int numBenchScenarios = sizeof(benchScenarios) / sizeof(benchScenarios[0]);
+
+static const int numDistractors = 5;
+
+static uint32_t benchHash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static int latticeValue(uint32_t seed, int gx, int gy)
+{
+    return benchHash(seed ^ benchHash(gx * 73856093u ^ gy * 19349663u)) & 0xff;
+}
+
+//Bilinearly interpolated random lattice, blended into img with the given weight (0..256)
+static void addValueNoise(Mat &img, uint32_t seed, int cell, int weight)
+{
+    for(int y = 0; y < img.rows; y++)
+    {
+        unsigned char *row = img.ptr<unsigned char>(y);
+        int gy = y / cell;
+        int fy = (y % cell) * 256 / cell;
+
+        for(int x = 0; x < img.cols; x++)
+        {
+            int gx = x / cell;
+            int fx = (x % cell) * 256 / cell;
+
+            int top = latticeValue(seed, gx, gy) * (256 - fx) + latticeValue(seed, gx + 1, gy) * fx;
+            int bottom = latticeValue(seed, gx, gy + 1) * (256 - fx) + latticeValue(seed, gx + 1, gy + 1) * fx;
+            int value = (top * (256 - fy) + bottom * fy) >> 16;
+
+            row[x] = (unsigned char)((row[x] * (256 - weight) + value * weight) >> 8);
+        }
+    }
+}
+
+//High contrast blocks with fine noise, like a textured object
+static Mat objectPattern(int width, int height, uint32_t seed)
+{
+    Mat texture(height, width, CV_8UC1);
+
+    for(int y = 0; y < height; y++)
+    {
+        unsigned char *row = texture.ptr<unsigned char>(y);
+
+        for(int x = 0; x < width; x++)
+        {
+            row[x] = 30 + latticeValue(seed, x / 6, y / 6) * 200 / 255;
+        }
+    }
+
+    addValueNoise(texture, seed + 1, 3, 64);
+
+    return texture;
+}
+
+SyntheticSequence::SyntheticSequence(int width, int height, int numFrames, const SyntheticScenario &scenario, uint32_t seed) :
+    width(width), height(height), numFrames(numFrames), scenario(scenario)
+{
+    objWidth = width / 8;
+    objHeight = height / 6;
+
+    background = Mat(height, width, CV_8UC1);
+    background.setTo(Scalar(128));
+    addValueNoise(background, seed, 48, 160);
+    addValueNoise(background, seed + 1, 8, 96);
+
+    objectTexture = objectPattern(objWidth, objHeight, seed + 2);
+
+    occluderTexture = Mat(objHeight, objWidth, CV_8UC1);
+    occluderTexture.setTo(Scalar(100));
+    addValueNoise(occluderTexture, seed + 3, 32, 64);
+
+    for(int i = 0; i < numDistractors; i++)
+    {
+        distractorTextures.push_back(objectPattern(objWidth, objHeight, seed + 10 + i));
+    }
+}
+
+Rect SyntheticSequence::groundTruth(int frame) const
+{
+    double cx = width / 2.0 + 0.3 * width * sin(2 * CV_PI * frame / 160.0);
+    double cy = height / 2.0 + 0.25 * height * sin(2 * CV_PI * frame / 110.0 + 1.0);
+    double scale = (scenario.scaleChange) ? 1 + 0.3 * sin(2 * CV_PI * frame / 200.0) : 1;
+
+    int w = (int) floor(objWidth * scale + 0.5);
+    int h = (int) floor(objHeight * scale + 0.5);
+
+    return Rect((int) floor(cx - w / 2.0 + 0.5), (int) floor(cy - h / 2.0 + 0.5), w, h);
+}
+
+bool SyntheticSequence::isOccluded(int frame) const
+{
+    return scenario.occlusion && frame >= numFrames * 45 / 100 && frame < numFrames * 55 / 100;
+}
+
+//Distractors bounce between the image borders at constant speed
+Rect SyntheticSequence::distractor(int index, int frame) const
+{
+    uint32_t h = benchHash(index + 1);
+    int rangeX = width - objWidth;
+    int rangeY = height - objHeight;
+    int speedX = 1 + (h & 3) * width / 320;
+    int speedY = 1 + ((h >> 2) & 3) * height / 240;
+
+    int px = (int)((h >> 4) % (2 * rangeX) + speedX * frame) % (2 * rangeX);
+    int py = (int)((h >> 14) % (2 * rangeY) + speedY * frame) % (2 * rangeY);
+
+    return Rect((px > rangeX) ? 2 * rangeX - px : px, (py > rangeY) ? 2 * rangeY - py : py, objWidth, objHeight);
+}
+
+//Nearest neighbour scaling into rect, clipped to img
+void SyntheticSequence::drawTexture(Mat &img, const Mat &texture, const Rect &rect)
+{
+    for(int y = max(0, rect.y); y < min(img.rows, rect.y + rect.height); y++)
+    {
+        unsigned char *row = img.ptr<unsigned char>(y);
+        const unsigned char *src = texture.ptr<unsigned char>((y - rect.y) * texture.rows / rect.height);
+
+        for(int x = max(0, rect.x); x < min(img.cols, rect.x + rect.width); x++)
+        {
+            row[x] = src[(x - rect.x) * texture.cols / rect.width];
+        }
+    }
+}
+
+void SyntheticSequence::render(int frame, Mat &grey) const
+{
+    background.copyTo(grey);
+
+    if(scenario.clutter)
+    {
+        for(int i = 0; i < numDistractors; i++)
+        {
+            drawTexture(grey, distractorTextures[i], distractor(i, frame));
+        }
+    }
+
+    Rect bb = groundTruth(frame);
+    drawTexture(grey, objectTexture, bb);
+
+    if(isOccluded(frame))
+    {
+        int marginX = bb.width / 10;
+        int marginY = bb.height / 10;
+        drawTexture(grey, occluderTexture, Rect(bb.x - marginX, bb.y - marginY, bb.width + 2 * marginX, bb.height + 2 * marginY));
+    }
+}
+
+uint64_t benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//Resets the high water mark of the resident set (Linux 4.0 and later)
+void benchResetPeakMemory()
+{
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+
+    if(file != NULL)
+    {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+long benchPeakMemory()
+{
+    FILE *file = fopen("/proc/self/status", "r");
+
+    if(file != NULL)
+    {
+        char line[256];
+        long peak = -1;
+
+        while(fgets(line, sizeof(line), file) != NULL)
+        {
+            if(strncmp(line, "VmHWM:", 6) == 0)
+            {
+                peak = atol(line + 6);
+                break;
+            }
+        }
+
+        fclose(file);
+
+        if(peak >= 0)
+        {
+            return peak;
+        }
+    }
+
+    //Peak of the whole process
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+double benchPercentile(const vector<double> &sortedValues, double p)
+{
+    if(sortedValues.empty())
+    {
+        return 0;
+    }
+
+    size_t rank = (size_t) ceil(p * sortedValues.size());
+
+    if(rank < 1) rank = 1;
+
+    if(rank > sortedValues.size()) rank = sortedValues.size();
+
+    return sortedValues[rank - 1];
+}
+
+} /* namespace tld */
@@ -0,0 +1,84 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * BenchUtil.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef BENCHUTIL_H_
+#define BENCHUTIL_H_
+
+#include <vector>
+
+#include <stdint.h>
+
+#include <opencv/cv.h>
+
+namespace tld
+{
+
+struct SyntheticScenario
+{
+    const char *name;
+    bool clutter; //Distractors with a texture similar to the object
+    bool occlusion; //The object is covered for a tenth of the sequence
+    bool scaleChange; //The object grows and shrinks by 30%
+};
+
+extern const SyntheticScenario benchScenarios[];
+extern const int numBenchScenarios;
+
+/*
+ * A reproducible sequence of a textured object moving over a textured
+ * background. Every frame is a pure function of the parameters and the frame
+ * number; no OpenCV random number generator or filter is involved, so the
+ * pixels are identical on every machine and OpenCV version.
+ */
+class SyntheticSequence
+{
+    int width;
+    int height;
+    int numFrames;
+    SyntheticScenario scenario;
+    int objWidth;
+    int objHeight;
+    cv::Mat background;
+    cv::Mat objectTexture;
+    cv::Mat occluderTexture;
+    std::vector<cv::Mat> distractorTextures;
+
+    cv::Rect distractor(int index, int frame) const;
+    static void drawTexture(cv::Mat &img, const cv::Mat &texture, const cv::Rect &rect);
+
+public:
+    SyntheticSequence(int width, int height, int numFrames, const SyntheticScenario &scenario, uint32_t seed);
+
+    cv::Rect groundTruth(int frame) const;
+    bool isOccluded(int frame) const;
+    void render(int frame, cv::Mat &grey) const; //grey must be CV_8UC1 of the sequence size
+};
+
+uint64_t benchNow(); //Nanoseconds, monotonic
+void benchResetPeakMemory();
+long benchPeakMemory(); //Peak resident set size since the last reset, in kB
+double benchPercentile(const std::vector<double> &sortedValues, double p);
+
+} /* namespace tld */
+#endif /* BENCHUTIL_H_ */
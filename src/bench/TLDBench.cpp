@@ -0,0 +1,458 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * TLDBench.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+/*
+ * tld_bench: runs TLD headlessly on synthetic sequences and reports
+ * throughput, per-frame latency percentiles and peak memory.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BenchAlloc.h"
+#include "BenchUtil.h"
+#include "TLD.h"
+#include "TLDUtil.h"
+
+using namespace tld;
+using namespace cv;
+using namespace std;
+
+struct BenchResult
+{
+    string scenario;
+    int width;
+    int height;
+    int numFrames;
+    double fps;
+    double mean; //Milliseconds
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double meanOverlap; //Over the frames where the object is visible
+    double successRate; //Fraction of visible frames with overlap > 0.5
+    int coarseStep;
+    int hugePages; //HugePageMode of the detector
+    double windowsPerFrame; //Windows scanned by the detector
+    double allocationsPerFrame; //Heap allocations in processImage, over the second half of the sequence
+    long peakMemory; //kB
+    bool hardwareCounters;
+    double events[NUM_STAGES][NUM_PERF_EVENTS]; //Per frame
+};
+
+static void usage()
+{
+    printf("Usage: tld_bench [-n <frames>] [-r <width>x<height>]... [-s <scenario>]... [-e <seed>] [-g <step>] [-H <mode>] [-j <json>] [-c <csv>] [-m] [-p]\n");
+    printf("  -n  frames per sequence (default 300)\n");
+    printf("  -r  resolution, may be repeated (default 320x240, 640x480, 1280x720)\n");
+    printf("  -s  scenario, may be repeated (default all):");
+
+    for(int i = 0; i < numBenchScenarios; i++)
+    {
+        printf(" %s", benchScenarios[i].name);
+    }
+
+    printf("\n  -e  seed (default 0)\n");
+    printf("  -g  coarse step of the detector, 1 scans all windows (default 1)\n");
+    printf("  -H  huge pages for the per-window arrays and integral images: off, transparent or explicit (default off)\n");
+    printf("  -j  write results as JSON\n");
+    printf("  -c  write results as CSV\n");
+    printf("  -m  include per-stage metrics in the JSON output\n");
+    printf("  -p  count cycles, instructions, cache, branch and dTLB misses per stage (Linux)\n");
+}
+
+static BenchResult runSequence(const SyntheticScenario &scenario, int width, int height, int numFrames, unsigned seed,
+                               int coarseStep, int hugePages, bool hardwareCounters, FILE *metricsFile)
+{
+    SyntheticSequence sequence(width, height, numFrames, scenario, seed);
+
+    Mat grey(height, width, CV_8UC1);
+    Mat colour;
+
+    benchResetPeakMemory();
+    srand(seed);
+
+    TLD *tld = new TLD();
+    tld->detectorCascade->setImgSize(width, height, grey.step);
+    tld->detectorCascade->coarseStep = coarseStep;
+    tld->detectorCascade->hugePages = hugePages;
+    tld->metrics->hardwareCounters = hardwareCounters;
+
+    sequence.render(0, grey);
+    Rect bb = sequence.groundTruth(0);
+    tld->selectObject(grey, &bb);
+
+    //The first frame is always scanned in full
+    uint64_t initialWindows = tld->metrics->counter(COUNT_WINDOWS);
+
+    vector<double> latencies;
+    double overlapSum = 0;
+    int numVisible = 0;
+    int numSuccess = 0;
+    uint64_t totalTime = 0;
+    uint64_t allocations = 0;
+
+    //The first half warms up the buffers that are kept between frames
+    int steadyFrame = numFrames / 2;
+
+    for(int frame = 1; frame < numFrames; frame++)
+    {
+        sequence.render(frame, grey);
+        cvtColor(grey, colour, CV_GRAY2BGR);
+
+        uint64_t beginAllocations = benchHeapAllocations();
+        uint64_t begin = benchNow();
+        tld->processImage(colour);
+        uint64_t elapsed = benchNow() - begin;
+
+        if(frame >= steadyFrame) allocations += benchHeapAllocations() - beginAllocations;
+
+        totalTime += elapsed;
+        latencies.push_back(elapsed / 1e6);
+
+        if(!sequence.isOccluded(frame))
+        {
+            float overlap = (tld->currBB != NULL) ? tldOverlapRectRect(*tld->currBB, sequence.groundTruth(frame)) : 0;
+            overlapSum += overlap;
+            numVisible++;
+
+            if(overlap > 0.5) numSuccess++;
+        }
+    }
+
+    sort(latencies.begin(), latencies.end());
+
+    BenchResult result;
+    result.scenario = scenario.name;
+    result.width = width;
+    result.height = height;
+    result.numFrames = latencies.size();
+    result.fps = (totalTime > 0) ? latencies.size() / (totalTime / 1e9) : 0;
+    result.mean = (latencies.size() > 0) ? totalTime / 1e6 / latencies.size() : 0;
+    result.p50 = benchPercentile(latencies, 0.5);
+    result.p90 = benchPercentile(latencies, 0.9);
+    result.p99 = benchPercentile(latencies, 0.99);
+    result.max = (latencies.size() > 0) ? latencies.back() : 0;
+    result.meanOverlap = (numVisible > 0) ? overlapSum / numVisible : 0;
+    result.successRate = (numVisible > 0) ? (double) numSuccess / numVisible : 0;
+    result.coarseStep = coarseStep;
+    result.hugePages = hugePages;
+    result.windowsPerFrame = (result.numFrames > 0) ? (double)(tld->metrics->counter(COUNT_WINDOWS) - initialWindows) / result.numFrames : 0;
+    result.allocationsPerFrame = (double) allocations / (numFrames - steadyFrame);
+    result.peakMemory = benchPeakMemory();
+    result.hardwareCounters = hardwareCounters;
+
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        for(int j = 0; j < NUM_PERF_EVENTS; j++)
+        {
+            result.events[i][j] = (result.numFrames > 0) ? (double) tld->metrics->events(i, j) / result.numFrames : 0;
+        }
+    }
+
+    if(metricsFile != NULL)
+    {
+        tld->metrics->writeJSON(metricsFile);
+    }
+
+    delete tld;
+
+    return result;
+}
+
+static void writeJSON(FILE *file, const vector<BenchResult> &results, const vector<string> &metrics)
+{
+    fprintf(file, "{\"runs\": [\n");
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(file, "{\"scenario\": \"%s\", \"width\": %d, \"height\": %d, \"frames\": %d, \"fps\": %.3f, "
+                "\"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, "
+                "\"mean_overlap\": %.4f, \"success_rate\": %.4f, \"coarse_step\": %d, \"huge_pages\": \"%s\", "
+                "\"windows_per_frame\": %.1f, \"allocations_per_frame\": %.2f, \"peak_memory_kb\": %ld",
+                r.scenario.c_str(), r.width, r.height, r.numFrames, r.fps, r.mean, r.p50, r.p90, r.p99, r.max,
+                r.meanOverlap, r.successRate, r.coarseStep, tldHugePageModeName(r.hugePages), r.windowsPerFrame,
+                r.allocationsPerFrame, r.peakMemory);
+
+        if(r.hardwareCounters)
+        {
+            fprintf(file, ", \"hardware_per_frame\": {");
+
+            for(int s = 0; s < NUM_STAGES; s++)
+            {
+                fprintf(file, "\"%s\": {", Metrics::stageName(s));
+
+                for(int e = 0; e < NUM_PERF_EVENTS; e++)
+                {
+                    fprintf(file, "\"%s\": %.1f%s", tldPerfEventName(e), r.events[s][e], (e + 1 < NUM_PERF_EVENTS) ? ", " : "");
+                }
+
+                fprintf(file, "}%s", (s + 1 < NUM_STAGES) ? ", " : "");
+            }
+
+            fprintf(file, "}");
+        }
+
+        if(i < metrics.size())
+        {
+            fprintf(file, ", \"metrics\": %s", metrics[i].c_str());
+        }
+
+        fprintf(file, "}%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(file, "]}\n");
+}
+
+//Per stage and frame: cycles, instructions per cycle and misses per thousand instructions
+static void printHardwareCounters(const BenchResult &r)
+{
+    printf("  %-12s %14s %6s %16s %17s %15s\n", "stage", "cycles/frame", "IPC", "cache misses/ki", "branch misses/ki", "dTLB misses/ki");
+
+    for(int s = 0; s < NUM_STAGES; s++)
+    {
+        double cycles = r.events[s][PERF_CYCLES];
+        double instructions = r.events[s][PERF_INSTRUCTIONS];
+
+        if(cycles <= 0) continue;
+
+        printf("  %-12s %14.0f %6.2f %16.2f %17.2f %15.3f\n", Metrics::stageName(s), cycles, instructions / cycles,
+               (instructions > 0) ? 1000 * r.events[s][PERF_CACHE_MISSES] / instructions : 0,
+               (instructions > 0) ? 1000 * r.events[s][PERF_BRANCH_MISSES] / instructions : 0,
+               (instructions > 0) ? 1000 * r.events[s][PERF_DTLB_MISSES] / instructions : 0);
+    }
+}
+
+static void writeCSV(FILE *file, const vector<BenchResult> &results)
+{
+    fprintf(file, "scenario,width,height,frames,fps,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_overlap,success_rate,coarse_step,huge_pages,windows_per_frame,allocations_per_frame,peak_memory_kb\n");
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(file, "%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f,%d,%s,%.1f,%.2f,%ld\n",
+                r.scenario.c_str(), r.width, r.height, r.numFrames, r.fps, r.mean, r.p50, r.p90, r.p99, r.max,
+                r.meanOverlap, r.successRate, r.coarseStep, tldHugePageModeName(r.hugePages), r.windowsPerFrame,
+                r.allocationsPerFrame, r.peakMemory);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int numFrames = 300;
+    unsigned seed = 0;
+    int coarseStep = 1;
+    int hugePages = HUGE_PAGES_OFF;
+    const char *jsonPath = NULL;
+    const char *csvPath = NULL;
+    bool withMetrics = false;
+    bool hardwareCounters = false;
+    vector<Size> resolutions;
+    vector<const SyntheticScenario *> scenarios;
+
+    int c;
+
+    while((c = getopt(argc, argv, "n:r:s:e:g:H:j:c:mph")) != -1)
+    {
+        switch(c)
+        {
+        case 'n':
+            numFrames = atoi(optarg);
+            break;
+        case 'r':
+        {
+            int w, h;
+
+            if(sscanf(optarg, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            {
+                printf("Error: Invalid resolution: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            resolutions.push_back(Size(w, h));
+            break;
+        }
+        case 's':
+        {
+            const SyntheticScenario *scenario = NULL;
+
+            for(int i = 0; i < numBenchScenarios; i++)
+            {
+                if(string(optarg) == benchScenarios[i].name) scenario = &benchScenarios[i];
+            }
+
+            if(scenario == NULL)
+            {
+                printf("Error: Unknown scenario: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            scenarios.push_back(scenario);
+            break;
+        }
+        case 'e':
+            seed = atoi(optarg);
+            break;
+        case 'g':
+            coarseStep = atoi(optarg);
+
+            if(coarseStep < 1)
+            {
+                printf("Error: Invalid coarse step: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'H':
+            hugePages = tldHugePageMode(optarg);
+
+            if(hugePages < 0)
+            {
+                printf("Error: Unknown huge page mode: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'j':
+            jsonPath = optarg;
+            break;
+        case 'c':
+            csvPath = optarg;
+            break;
+        case 'm':
+            withMetrics = true;
+            break;
+        case 'p':
+            hardwareCounters = true;
+            break;
+        default:
+            usage();
+            return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if(numFrames < 2)
+    {
+        printf("Error: At least 2 frames are needed\n");
+        return EXIT_FAILURE;
+    }
+
+    if(resolutions.empty())
+    {
+        resolutions.push_back(Size(320, 240));
+        resolutions.push_back(Size(640, 480));
+        resolutions.push_back(Size(1280, 720));
+    }
+
+    if(scenarios.empty())
+    {
+        for(int i = 0; i < numBenchScenarios; i++)
+        {
+            scenarios.push_back(&benchScenarios[i]);
+        }
+    }
+
+    vector<BenchResult> results;
+    vector<string> metrics;
+
+    printf("%-10s %10s %8s %9s %9s %9s %9s %9s %8s %8s %9s %8s %10s\n", "scenario", "size", "fps", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "overlap", "success", "windows", "allocs", "peak kB");
+
+    for(size_t r = 0; r < resolutions.size(); r++)
+    {
+        for(size_t s = 0; s < scenarios.size(); s++)
+        {
+            FILE *metricsFile = (withMetrics) ? tmpfile() : NULL;
+
+            BenchResult result = runSequence(*scenarios[s], resolutions[r].width, resolutions[r].height, numFrames, seed,
+                                             coarseStep, hugePages, hardwareCounters, metricsFile);
+            results.push_back(result);
+
+            if(metricsFile != NULL)
+            {
+                string json;
+                char buffer[4096];
+                size_t n;
+                rewind(metricsFile);
+
+                while((n = fread(buffer, 1, sizeof(buffer), metricsFile)) > 0)
+                {
+                    json.append(buffer, n);
+                }
+
+                fclose(metricsFile);
+                metrics.push_back(json);
+            }
+
+            char size[32];
+            sprintf(size, "%dx%d", result.width, result.height);
+            printf("%-10s %10s %8.2f %9.3f %9.3f %9.3f %9.3f %9.3f %8.3f %8.3f %9.0f %8.2f %10ld\n", result.scenario.c_str(), size, result.fps,
+                   result.mean, result.p50, result.p90, result.p99, result.max, result.meanOverlap, result.successRate,
+                   result.windowsPerFrame, result.allocationsPerFrame, result.peakMemory);
+
+            if(hardwareCounters)
+            {
+                printHardwareCounters(result);
+            }
+
+            fflush(stdout);
+        }
+    }
+
+    if(jsonPath != NULL)
+    {
+        FILE *file = fopen(jsonPath, "w");
+
+        if(file == NULL)
+        {
+            printf("Error: Unable to write %s\n", jsonPath);
+            return EXIT_FAILURE;
+        }
+
+        writeJSON(file, results, metrics);
+        fclose(file);
+    }
+
+    if(csvPath != NULL)
+    {
+        FILE *file = fopen(csvPath, "w");
+
+        if(file == NULL)
+        {
+            printf("Error: Unable to write %s\n", csvPath);
+            return EXIT_FAILURE;
+        }
+
+        writeCSV(file, results);
+        fclose(file);
+    }
+
+    return EXIT_SUCCESS;
+}
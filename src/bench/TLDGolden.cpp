@@ -0,0 +1,702 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * TLDGolden.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+/*
+ * tld_golden: records the per-frame output and the final model of a run on
+ * a synthetic sequence, and replays a recording to check that a build or a
+ * mode produces the same results, exactly or within tolerances.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "BenchUtil.h"
+#include "ModelFile.h"
+#include "TLD.h"
+#include "TLDUtil.h"
+
+using namespace tld;
+using namespace cv;
+using namespace std;
+
+static const char *GOLDEN_MAGIC = "TLDGOLDEN";
+static const int GOLDEN_VERSION = 1;
+
+struct GoldenFrame
+{
+    int frame;
+    int hasBB;
+    int x;
+    int y;
+    int width;
+    int height;
+    float conf;
+    int valid;
+    int learning;
+    int numVariance; //Windows that survived the variance filter
+    int numEnsemble;
+    int numConfident;
+    int numClusters;
+};
+
+struct GoldenRecord
+{
+    string scenario;
+    int width;
+    int height;
+    int numFrames;
+    unsigned seed;
+    vector<GoldenFrame> frames;
+};
+
+//Settings of the run under test; not part of the record, so that a
+//recording of the default mode can be replayed in any other mode
+struct GoldenMode
+{
+    int coarseStep;
+    int changeThreshold; //-1: no reuse of unchanged windows
+    int foregroundThreshold; //-1: no foreground gating
+    int hugePages;
+    int startModel; //START_*
+};
+
+enum
+{
+    START_SELECT, //Learn the object from the first frame
+    START_COPY, //Then write the model and load it back
+    START_SHARED //Then write the model and map it shared (see TLD::shareModel)
+};
+
+struct Tolerances
+{
+    int bb; //Pixels, per coordinate
+    float conf;
+    int count; //Survivor counts
+    float model; //Template values and posteriors
+    double quality; //Loss of mean overlap and success rate; -1: compare frames and model instead
+};
+
+//Tracking quality against the ground truth, over the frames the object is visible in, as in tld_bench
+struct GoldenQuality
+{
+    double meanOverlap;
+    double successRate; //Fraction of frames with overlap > 0.5
+};
+
+static string modelPath(const char *recordPath)
+{
+    return string(recordPath) + ".model";
+}
+
+static const SyntheticScenario *findScenario(const string &name)
+{
+    for(int i = 0; i < numBenchScenarios; i++)
+    {
+        if(name == benchScenarios[i].name) return &benchScenarios[i];
+    }
+
+    return NULL;
+}
+
+static GoldenFrame captureFrame(int frame, TLD *tld)
+{
+    GoldenFrame f;
+    memset(&f, 0, sizeof(f));
+    f.frame = frame;
+    f.hasBB = tld->currBB != NULL;
+
+    if(f.hasBB)
+    {
+        f.x = tld->currBB->x;
+        f.y = tld->currBB->y;
+        f.width = tld->currBB->width;
+        f.height = tld->currBB->height;
+    }
+
+    f.conf = tld->currConf;
+    f.valid = tld->valid;
+    f.learning = tld->learning;
+
+    DetectionResult *detectionResult = tld->detectorCascade->detectionResult;
+    f.numVariance = detectionResult->varianceIndices->size();
+    f.numEnsemble = detectionResult->ensembleIndices->size();
+    f.numConfident = detectionResult->confidentIndices->size();
+    f.numClusters = detectionResult->numClusters;
+
+    return f;
+}
+
+/*
+ * Runs the tracker on the sequence of the record and fills in its frames.
+ * The TLD instance is returned so the final model can be written or compared.
+ */
+static TLD *run(GoldenRecord *record, const SyntheticScenario &scenario, const GoldenMode &mode, const string &startPath)
+{
+    SyntheticSequence sequence(record->width, record->height, record->numFrames, scenario, record->seed);
+
+    Mat grey(record->height, record->width, CV_8UC1);
+    Mat colour;
+
+    srand(record->seed);
+
+    TLD *tld = new TLD();
+    tld->detectorCascade->setImgSize(record->width, record->height, grey.step);
+    tld->detectorCascade->coarseStep = mode.coarseStep;
+    tld->detectorCascade->reuseUnchanged = mode.changeThreshold >= 0;
+    tld->detectorCascade->changeThreshold = max(0, mode.changeThreshold);
+    tld->detectorCascade->hugePages = mode.hugePages;
+
+    if(mode.foregroundThreshold >= 0)
+    {
+        //The synthetic background is static, its running average converges
+        tld->detectorCascade->foregroundDetector->adaptive = true;
+        tld->detectorCascade->foregroundDetector->fgThreshold = mode.foregroundThreshold;
+    }
+
+    sequence.render(0, grey);
+    Rect bb = sequence.groundTruth(0);
+    tld->selectObject(grey, &bb);
+
+    //The object is found again by the detector in the first frame
+    if(mode.startModel != START_SELECT)
+    {
+        tld->writeToBinaryFile(startPath.c_str());
+        tld->shareModel = mode.startModel == START_SHARED;
+        tld->readFromFile(startPath.c_str());
+    }
+
+    record->frames.clear();
+
+    for(int frame = 1; frame < record->numFrames; frame++)
+    {
+        sequence.render(frame, grey);
+        cvtColor(grey, colour, CV_GRAY2BGR);
+        tld->processImage(colour);
+        record->frames.push_back(captureFrame(frame, tld));
+    }
+
+    return tld;
+}
+
+static bool writeRecord(const char *path, const GoldenRecord &record)
+{
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL)
+    {
+        printf("Error: Unable to write %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "%s %d\n", GOLDEN_MAGIC, GOLDEN_VERSION);
+    fprintf(file, "scenario %s\n", record.scenario.c_str());
+    fprintf(file, "size %d %d\n", record.width, record.height);
+    fprintf(file, "frames %d\n", record.numFrames);
+    fprintf(file, "seed %u\n", record.seed);
+    fprintf(file, "#frame hasBB x y width height conf valid learning variance ensemble confident clusters\n");
+
+    for(size_t i = 0; i < record.frames.size(); i++)
+    {
+        const GoldenFrame &f = record.frames[i];
+        //%.9g round-trips every float exactly
+        fprintf(file, "%d %d %d %d %d %d %.9g %d %d %d %d %d %d\n", f.frame, f.hasBB, f.x, f.y, f.width, f.height,
+                f.conf, f.valid, f.learning, f.numVariance, f.numEnsemble, f.numConfident, f.numClusters);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static bool readRecord(const char *path, GoldenRecord *record)
+{
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+    {
+        printf("Error: Unable to read %s\n", path);
+        return false;
+    }
+
+    char magic[16];
+    char scenario[64];
+    int version;
+
+    if(fscanf(file, "%15s %d scenario %63s size %d %d frames %d seed %u", magic, &version, scenario,
+              &record->width, &record->height, &record->numFrames, &record->seed) != 7
+            || strcmp(magic, GOLDEN_MAGIC) != 0 || version != GOLDEN_VERSION)
+    {
+        printf("Error: %s is not a golden record of version %d\n", path, GOLDEN_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    record->scenario = scenario;
+    record->frames.clear();
+
+    char line[512];
+
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        GoldenFrame f;
+
+        if(line[0] == '#') continue;
+
+        if(sscanf(line, "%d %d %d %d %d %d %g %d %d %d %d %d %d", &f.frame, &f.hasBB, &f.x, &f.y, &f.width, &f.height,
+                  &f.conf, &f.valid, &f.learning, &f.numVariance, &f.numEnsemble, &f.numConfident, &f.numClusters) == 13)
+        {
+            record->frames.push_back(f);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+/*
+ * Compares two frames, prints every difference beyond the tolerances if
+ * verbose is set, and returns true if there is none.
+ */
+static bool compareFrame(const GoldenFrame &expected, const GoldenFrame &actual, const Tolerances &tol, bool verbose)
+{
+    bool equal = true;
+
+#define GOLDEN_CHECK(field, tolerance, format) \
+    if(fabs((double) expected.field - (double) actual.field) > (tolerance)) \
+    { \
+        if(verbose) printf("  frame %d: " #field " expected " format ", got " format "\n", expected.frame, expected.field, actual.field); \
+        equal = false; \
+    }
+
+    GOLDEN_CHECK(hasBB, 0, "%d")
+
+    if(expected.hasBB && actual.hasBB)
+    {
+        GOLDEN_CHECK(x, tol.bb, "%d")
+        GOLDEN_CHECK(y, tol.bb, "%d")
+        GOLDEN_CHECK(width, tol.bb, "%d")
+        GOLDEN_CHECK(height, tol.bb, "%d")
+    }
+
+    GOLDEN_CHECK(conf, tol.conf, "%.9g")
+    GOLDEN_CHECK(valid, 0, "%d")
+    GOLDEN_CHECK(learning, 0, "%d")
+    GOLDEN_CHECK(numVariance, tol.count, "%d")
+    GOLDEN_CHECK(numEnsemble, tol.count, "%d")
+    GOLDEN_CHECK(numConfident, tol.count, "%d")
+    GOLDEN_CHECK(numClusters, tol.count, "%d")
+
+#undef GOLDEN_CHECK
+
+    return equal;
+}
+
+static GoldenQuality measureQuality(const GoldenRecord &record, const SyntheticSequence &sequence)
+{
+    double overlapSum = 0;
+    int numVisible = 0;
+    int numSuccess = 0;
+
+    for(size_t i = 0; i < record.frames.size(); i++)
+    {
+        const GoldenFrame &f = record.frames[i];
+
+        if(sequence.isOccluded(f.frame)) continue;
+
+        float overlap = f.hasBB ? tldOverlapRectRect(Rect(f.x, f.y, f.width, f.height), sequence.groundTruth(f.frame)) : 0;
+        overlapSum += overlap;
+        numVisible++;
+
+        if(overlap > 0.5) numSuccess++;
+    }
+
+    GoldenQuality quality;
+    quality.meanOverlap = (numVisible > 0) ? overlapSum / numVisible : 0;
+    quality.successRate = (numVisible > 0) ? (double) numSuccess / numVisible : 0;
+    return quality;
+}
+
+/*
+ * Checks that the replay tracks at most tolerance worse than the record, for
+ * modes that trade exactness for speed such as coarse-to-fine scanning.
+ */
+static bool compareQuality(const GoldenRecord &expected, const GoldenRecord &actual, const SyntheticScenario &scenario, double tolerance)
+{
+    SyntheticSequence sequence(expected.width, expected.height, expected.numFrames, scenario, expected.seed);
+    GoldenQuality e = measureQuality(expected, sequence);
+    GoldenQuality a = measureQuality(actual, sequence);
+
+    printf("  mean overlap %.4f -> %.4f (%+.4f), success rate %.4f -> %.4f (%+.4f)\n", e.meanOverlap, a.meanOverlap,
+           a.meanOverlap - e.meanOverlap, e.successRate, a.successRate, a.successRate - e.successRate);
+
+    return a.meanOverlap >= e.meanOverlap - tolerance && a.successRate >= e.successRate - tolerance;
+}
+
+static int countDifferences(const float *expected, const float *actual, int n, float tolerance, float *maxDiff)
+{
+    int numDifferent = 0;
+
+    for(int i = 0; i < n; i++)
+    {
+        float diff = fabs(expected[i] - actual[i]);
+
+        if(diff > tolerance) numDifferent++;
+
+        if(diff > *maxDiff) *maxDiff = diff;
+    }
+
+    return numDifferent;
+}
+
+static int countDifferences(const int32_t *expected, const int *actual, int n, int tolerance)
+{
+    int numDifferent = 0;
+
+    for(int i = 0; i < n; i++)
+    {
+        if(abs(expected[i] - actual[i]) > tolerance) numDifferent++;
+    }
+
+    return numDifferent;
+}
+
+static bool compareModel(const char *path, TLD *tld, const Tolerances &tol)
+{
+    ModelFile expected;
+
+    if(!expected.open(path))
+    {
+        printf("Error: Unable to read the recorded model %s\n", path);
+        return false;
+    }
+
+    const ModelFileHeader *header = expected.header;
+    INNClassifier *nn = tld->nnClassifier;
+    IEnsembleClassifier *ec = tld->detectorCascade->ensembleClassifier;
+
+    if(header->numTruePositives != nn->numTruePositives() || header->numFalsePositives != nn->numFalsePositives()
+            || header->numTrees != ec->numTrees || header->numFeatures != ec->numFeatures || header->numIndices != ec->numIndices)
+    {
+        printf("  model: expected %d/%d templates and %d trees, got %d/%d templates and %d trees\n",
+               header->numTruePositives, header->numFalsePositives, header->numTrees,
+               nn->numTruePositives(), nn->numFalsePositives(), ec->numTrees);
+        return false;
+    }
+
+    int patchValues = TLD_PATCH_SIZE * TLD_PATCH_SIZE;
+    float maxDiff = 0;
+    int numDifferent = 0;
+
+    for(int i = 0; i < header->numTruePositives; i++)
+    {
+        numDifferent += countDifferences(expected.truePositives() + i * patchValues, nn->truePositive(i), patchValues, tol.model, &maxDiff);
+    }
+
+    for(int i = 0; i < header->numFalsePositives; i++)
+    {
+        numDifferent += countDifferences(expected.falsePositives() + i * patchValues, nn->falsePositive(i), patchValues, tol.model, &maxDiff);
+    }
+
+    int numLeaves = ec->numTrees * ec->numIndices;
+    numDifferent += countDifferences(expected.features(), ec->features, 4 * ec->numFeatures * ec->numTrees, 0, &maxDiff);
+    numDifferent += countDifferences(expected.posteriors(), ec->posteriors, numLeaves, tol.model, &maxDiff);
+    numDifferent += countDifferences(expected.positives(), ec->positives, numLeaves, tol.count);
+    numDifferent += countDifferences(expected.negatives(), ec->negatives, numLeaves, tol.count);
+
+    if(numDifferent > 0)
+    {
+        printf("  model: %d values differ, largest difference %g\n", numDifferent, maxDiff);
+        return false;
+    }
+
+    return true;
+}
+
+static void usage()
+{
+    printf("Usage: tld_golden -o <record> [-s <scenario>] [-r <width>x<height>] [-n <frames>] [-e <seed>] [-t <threads>] [<mode>]\n");
+    printf("       tld_golden -i <record> [-b <pixels>] [-f <conf>] [-k <count>] [-m <value>] [-t <threads>] [-v] [<mode>]\n");
+    printf("       tld_golden -i <record> -q <loss> [-t <threads>] [<mode>]\n");
+    printf("  -o  record a reference run into <record> and <record>.model\n");
+    printf("  -i  replay <record> and compare against it\n");
+    printf("  -s  scenario (default moving):");
+
+    for(int i = 0; i < numBenchScenarios; i++)
+    {
+        printf(" %s", benchScenarios[i].name);
+    }
+
+    printf("\n  -r  resolution (default 320x240)\n");
+    printf("  -n  frames (default 300)\n");
+    printf("  -e  seed (default 0)\n");
+    printf("  -t  number of OpenMP threads\n");
+    printf("  -b  tolerance of the bounding box coordinates in pixels (default 0)\n");
+    printf("  -f  tolerance of the confidence (default 0)\n");
+    printf("  -k  tolerance of the survivor counts and leaf counters (default 0)\n");
+    printf("  -m  tolerance of template values and posteriors (default 0)\n");
+    printf("  -q  instead of frames and model, compare the mean overlap and the success rate against the ground truth;\n");
+    printf("      each may drop by at most <loss>\n");
+    printf("  -v  list every difference, not only the first one\n");
+    printf("Modes, for recording and replaying:\n");
+    printf("  -g  coarse step of the detector, 1 scans all windows (default 1)\n");
+    printf("  -u  reuse the outcome of unchanged windows, with this change threshold\n");
+    printf("  -a  gate windows with the foreground against a running average background, with this threshold\n");
+    printf("  -H  huge pages for the per-window arrays and integral images: off, transparent or explicit (default off)\n");
+    printf("  -M  after the first frame, write the model to <record>.start and load it: copy or shared\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *outputPath = NULL;
+    const char *inputPath = NULL;
+    GoldenRecord record;
+    record.scenario = benchScenarios[0].name;
+    record.width = 320;
+    record.height = 240;
+    record.numFrames = 300;
+    record.seed = 0;
+    Tolerances tol = {0, 0, 0, 0, -1};
+    GoldenMode mode = {1, -1, -1, HUGE_PAGES_OFF, START_SELECT};
+    bool verbose = false;
+
+    int c;
+
+    while((c = getopt(argc, argv, "o:i:s:r:n:e:t:b:f:k:m:q:g:u:a:H:M:vh")) != -1)
+    {
+        switch(c)
+        {
+        case 'o':
+            outputPath = optarg;
+            break;
+        case 'i':
+            inputPath = optarg;
+            break;
+        case 's':
+            record.scenario = optarg;
+            break;
+        case 'r':
+            if(sscanf(optarg, "%dx%d", &record.width, &record.height) != 2 || record.width <= 0 || record.height <= 0)
+            {
+                printf("Error: Invalid resolution: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'n':
+            record.numFrames = atoi(optarg);
+            break;
+        case 'e':
+            record.seed = atoi(optarg);
+            break;
+        case 't':
+#ifdef _OPENMP
+            omp_set_num_threads(atoi(optarg));
+#endif
+            break;
+        case 'b':
+            tol.bb = atoi(optarg);
+            break;
+        case 'f':
+            tol.conf = atof(optarg);
+            break;
+        case 'k':
+            tol.count = atoi(optarg);
+            break;
+        case 'm':
+            tol.model = atof(optarg);
+            break;
+        case 'q':
+            tol.quality = atof(optarg);
+
+            if(tol.quality < 0)
+            {
+                printf("Error: Invalid quality tolerance: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'g':
+            mode.coarseStep = atoi(optarg);
+
+            if(mode.coarseStep < 1)
+            {
+                printf("Error: Invalid coarse step: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'u':
+            mode.changeThreshold = atoi(optarg);
+            break;
+        case 'a':
+            mode.foregroundThreshold = atoi(optarg);
+            break;
+        case 'H':
+            mode.hugePages = tldHugePageMode(optarg);
+
+            if(mode.hugePages < 0)
+            {
+                printf("Error: Unknown huge page mode: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'M':
+            if(string(optarg) == "copy")
+            {
+                mode.startModel = START_COPY;
+            }
+            else if(string(optarg) == "shared")
+            {
+                mode.startModel = START_SHARED;
+            }
+            else
+            {
+                printf("Error: Unknown start model: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        default:
+            usage();
+            return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if((outputPath == NULL) == (inputPath == NULL))
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    if(inputPath != NULL && !readRecord(inputPath, &record))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const SyntheticScenario *scenario = findScenario(record.scenario);
+
+    if(scenario == NULL)
+    {
+        printf("Error: Unknown scenario: %s\n", record.scenario.c_str());
+        return EXIT_FAILURE;
+    }
+
+    if(record.numFrames < 2)
+    {
+        printf("Error: At least 2 frames are needed\n");
+        return EXIT_FAILURE;
+    }
+
+    string startPath = string((outputPath != NULL) ? outputPath : inputPath) + ".start";
+
+    if(outputPath != NULL)
+    {
+        TLD *tld = run(&record, *scenario, mode, startPath);
+        bool ok = writeRecord(outputPath, record);
+        tld->writeToBinaryFile(modelPath(outputPath).c_str());
+        delete tld;
+
+        if(mode.startModel != START_SELECT) unlink(startPath.c_str());
+
+        if(ok) printf("Recorded %d frames of %s %dx%d to %s\n", (int) record.frames.size(), record.scenario.c_str(),
+                          record.width, record.height, outputPath);
+
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    GoldenRecord actual = record;
+    TLD *tld = run(&actual, *scenario, mode, startPath);
+
+    if(tol.quality >= 0)
+    {
+        delete tld;
+
+        if(mode.startModel != START_SELECT) unlink(startPath.c_str());
+
+        if(!compareQuality(record, actual, *scenario, tol.quality))
+        {
+            printf("FAIL: Tracking quality dropped by more than %g\n", tol.quality);
+            return EXIT_FAILURE;
+        }
+
+        printf("PASS: Tracking quality is within %g of %s\n", tol.quality, inputPath);
+        return EXIT_SUCCESS;
+    }
+
+    int numDifferent = 0;
+    int firstDifferent = -1;
+
+    for(size_t i = 0; i < record.frames.size() && i < actual.frames.size(); i++)
+    {
+        if(!compareFrame(record.frames[i], actual.frames[i], tol, verbose || firstDifferent < 0))
+        {
+            if(firstDifferent < 0) firstDifferent = record.frames[i].frame;
+
+            numDifferent++;
+        }
+    }
+
+    if(record.frames.size() != actual.frames.size())
+    {
+        printf("  expected %d frames, got %d\n", (int) record.frames.size(), (int) actual.frames.size());
+        numDifferent++;
+    }
+
+    bool modelEqual = compareModel(modelPath(inputPath).c_str(), tld, tol);
+    delete tld;
+
+    if(mode.startModel != START_SELECT) unlink(startPath.c_str());
+
+    if(numDifferent > 0)
+    {
+        printf("FAIL: %d of %d frames differ, the first one is frame %d\n", numDifferent, (int) record.frames.size(), firstDifferent);
+    }
+
+    if(!modelEqual)
+    {
+        printf("FAIL: The final model differs\n");
+    }
+
+    if(numDifferent > 0 || !modelEqual)
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: %d frames and the final model match %s\n", (int) record.frames.size(), inputPath);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,935 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * TLDMicroBench.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+/*
+ * tld_microbench: times the hot kernels of the tracker in isolation,
+ * parameterized by image size, number of windows and number of templates.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BBPredict.h"
+#include "BB.h"
+#include "BenchUtil.h"
+#include "BlobResult.h"
+#include "ConnectedComponents.h"
+#include "DetectorCascade.h"
+#include "ForegroundDetector.h"
+#include "IntegralImage.h"
+#include "Lk.h"
+#include "TLD.h"
+#include "TLDUtil.h"
+
+using namespace tld;
+using namespace cv;
+using namespace std;
+
+#define MICROBENCH_POINTS 100
+
+static volatile double sink; //Keeps results alive
+
+struct Fixture
+{
+    Mat img0;
+    Mat img1;
+    IplImage ipl0;
+    IplImage ipl1;
+    Mat foreground; //Thresholded difference of both images
+    ConnectedComponents components;
+    TLD *tld;
+    IntegralImage<int> *integral;
+    IntegralImage<long long> *integralSquared;
+    vector<int> windowIndices;
+    vector<int> confidentIndices;
+    vector<int> windowsByOverlap;
+    Rect object; //Ground truth of the first frame
+    vector<float> overlaps; //One per window
+    vector<pair<int, float> > overlapping;
+    NormalizedPatch patch;
+    float bb[4]; //x1 y1 x2 y2
+    float points[2 * MICROBENCH_POINTS];
+    CvPoint2D32f pt0[MICROBENCH_POINTS];
+    CvPoint2D32f pt1[MICROBENCH_POINTS];
+    string textModelPath;
+    string binaryModelPath;
+
+    //Current parameters
+    int numWindows;
+    int numTemplates;
+    int numConfident;
+};
+
+enum KernelParams
+{
+    USES_SIZE = 1,
+    USES_WINDOWS = 2,
+    USES_TEMPLATES = 4,
+    USES_CONFIDENT = 8
+};
+
+struct Kernel
+{
+    const char *name;
+    int params;
+    void (*setUp)(Fixture *f); //Not timed, may be NULL
+    void (*run)(Fixture *f);
+    int (*items)(Fixture *f); //Work items per run, for the time per item
+};
+
+static DetectorCascade *cascade(Fixture *f)
+{
+    return dynamic_cast<DetectorCascade *>(f->tld->detectorCascade);
+}
+
+static int onePerRun(Fixture *)
+{
+    return 1;
+}
+
+static int pixelsPerRun(Fixture *f)
+{
+    return f->img0.rows * f->img0.cols;
+}
+
+static int windowsPerRun(Fixture *f)
+{
+    return f->windowIndices.size();
+}
+
+static int allWindowsPerRun(Fixture *f)
+{
+    return cascade(f)->numWindows;
+}
+
+static int confidentPerRun(Fixture *f)
+{
+    return f->confidentIndices.size();
+}
+
+static int pointsPerRun(Fixture *)
+{
+    return MICROBENCH_POINTS;
+}
+
+static void runCalcIntImg(Fixture *f)
+{
+    f->integral->calcIntImg(f->img0);
+    sink = f->integral->data[0];
+}
+
+static void runCalcIntImgSquared(Fixture *f)
+{
+    f->integralSquared->calcIntImg(f->img0, true);
+    sink = f->integralSquared->data[0];
+}
+
+static void setUpDetector(Fixture *f)
+{
+    dynamic_cast<VarianceFilter *>(cascade(f)->varianceFilter)->nextIteration(f->img0);
+    dynamic_cast<EnsembleClassifier *>(cascade(f)->ensembleClassifier)->nextIteration(f->img0);
+}
+
+static void runVarianceFilter(Fixture *f)
+{
+    VarianceFilter *varianceFilter = dynamic_cast<VarianceFilter *>(cascade(f)->varianceFilter);
+    int passed = 0;
+
+    for(size_t i = 0; i < f->windowIndices.size(); i++)
+    {
+        passed += varianceFilter->filter(f->windowIndices[i]);
+    }
+
+    sink = passed;
+}
+
+static void runCalcFernFeature(Fixture *f)
+{
+    EnsembleClassifier *ensembleClassifier = dynamic_cast<EnsembleClassifier *>(cascade(f)->ensembleClassifier);
+    int numTrees = ensembleClassifier->numTrees;
+    int sum = 0;
+
+    for(size_t i = 0; i < f->windowIndices.size(); i++)
+    {
+        for(int j = 0; j < numTrees; j++)
+        {
+            sum += ensembleClassifier->calcFernFeature(f->windowIndices[i], j);
+        }
+    }
+
+    sink = sum;
+}
+
+static void runNcc(Fixture *f)
+{
+    NNClassifier *nnClassifier = dynamic_cast<NNClassifier *>(f->tld->nnClassifier);
+    sink = nnClassifier->ncc(f->patch.values, nnClassifier->truePositive(0));
+}
+
+static void runClassifyPatch(Fixture *f)
+{
+    sink = dynamic_cast<NNClassifier *>(f->tld->nnClassifier)->classifyPatch(&f->patch);
+}
+
+static void runExtractNormalizedPatch(Fixture *f)
+{
+    const WindowGrid &windowGrid = cascade(f)->windowGrid;
+    int window[TLD_WINDOW_SIZE];
+
+    for(size_t i = 0; i < f->windowIndices.size(); i++)
+    {
+        windowGrid.window(f->windowIndices[i], window);
+        tldExtractNormalizedPatchBB(f->img0, window, f->patch.values);
+    }
+
+    sink = f->patch.values[0];
+}
+
+static void runClustering(Fixture *f)
+{
+    DetectionResult *detectionResult = cascade(f)->detectionResult;
+    detectionResult->reset();
+    detectionResult->confidentIndices->assign(f->confidentIndices.begin(), f->confidentIndices.end());
+    cascade(f)->clustering->clusterConfidentIndices();
+    sink = detectionResult->numClusters;
+}
+
+//Full sweep over the grid, as learning selected its samples before
+static void runOverlapRect(Fixture *f)
+{
+    f->overlaps.resize(cascade(f)->numWindows);
+    tldOverlapRect(&cascade(f)->windowGrid, &f->object, &f->overlaps[0]);
+    sink = f->overlaps[0];
+}
+
+//Windows that overlap the object by at least 0.2, as learning selects them
+static void runOverlapping(Fixture *f)
+{
+    f->overlapping.clear();
+    tldOverlapping(&cascade(f)->windowGrid, &f->object, 0.2, &f->overlapping);
+    sink = f->overlapping.size();
+}
+
+static void runConnectedComponents(Fixture *f)
+{
+    f->components.label(f->foreground, 0);
+    sink = f->components.boxes.size();
+}
+
+//The labeling ForegroundDetector used before, for comparison
+static void runCvBlobs(Fixture *f)
+{
+    IplImage im = (IplImage)f->foreground;
+    CBlobResult blobs = CBlobResult(&im, NULL, 0);
+    int sum = 0;
+
+    for(int i = 0; i < blobs.GetNumBlobs(); i++)
+    {
+        sum += blobs.GetBlob(i)->GetBoundingBox().width;
+    }
+
+    sink = sum;
+}
+
+static void runTrackLK(Fixture *f)
+{
+    float tracked[2 * MICROBENCH_POINTS];
+    float fb[MICROBENCH_POINTS];
+    float ncc[MICROBENCH_POINTS];
+    char status[MICROBENCH_POINTS];
+
+    memcpy(tracked, f->points, sizeof(tracked));
+
+    trackLK(&f->ipl0, &f->ipl1, f->points, MICROBENCH_POINTS, tracked, MICROBENCH_POINTS, 5, fb, ncc, status, f->tld->frameArena);
+
+    sink = tracked[0];
+}
+
+static void runPredictbb(Fixture *f)
+{
+    float bbnew[4];
+    float scaleshift;
+    predictbb(f->bb, f->pt0, f->pt1, MICROBENCH_POINTS, bbnew, &scaleshift, f->tld->frameArena);
+    sink = bbnew[0];
+}
+
+static void runWriteTextModel(Fixture *f)
+{
+    f->tld->writeToFile(f->textModelPath.c_str());
+}
+
+static void runReadTextModel(Fixture *f)
+{
+    f->tld->readFromFile(f->textModelPath.c_str());
+}
+
+static void runWriteBinaryModel(Fixture *f)
+{
+    f->tld->writeToBinaryFile(f->binaryModelPath.c_str());
+}
+
+static void runReadBinaryModel(Fixture *f)
+{
+    f->tld->readFromBinaryFile(f->binaryModelPath.c_str());
+}
+
+static const Kernel kernels[] =
+{
+    {"calcIntImg", USES_SIZE, NULL, runCalcIntImg, pixelsPerRun},
+    {"calcIntImgSquared", USES_SIZE, NULL, runCalcIntImgSquared, pixelsPerRun},
+    {"varianceFilter", USES_SIZE | USES_WINDOWS, setUpDetector, runVarianceFilter, windowsPerRun},
+    {"calcFernFeature", USES_SIZE | USES_WINDOWS, setUpDetector, runCalcFernFeature, windowsPerRun},
+    {"ncc", 0, NULL, runNcc, onePerRun},
+    {"classifyPatch", USES_TEMPLATES, NULL, runClassifyPatch, onePerRun},
+    {"extractNormalizedPatch", USES_SIZE | USES_WINDOWS, NULL, runExtractNormalizedPatch, windowsPerRun},
+    {"clustering", USES_SIZE | USES_CONFIDENT, NULL, runClustering, confidentPerRun},
+    {"overlapRect", USES_SIZE, NULL, runOverlapRect, allWindowsPerRun},
+    {"overlapping", USES_SIZE, NULL, runOverlapping, allWindowsPerRun},
+    {"connectedComponents", USES_SIZE, NULL, runConnectedComponents, pixelsPerRun},
+    {"cvBlobs", USES_SIZE, NULL, runCvBlobs, pixelsPerRun},
+    {"trackLK", USES_SIZE, NULL, runTrackLK, pointsPerRun},
+    {"predictbb", 0, NULL, runPredictbb, pointsPerRun},
+    {"writeTextModel", USES_SIZE | USES_TEMPLATES, NULL, runWriteTextModel, onePerRun},
+    {"readTextModel", USES_SIZE | USES_TEMPLATES, NULL, runReadTextModel, onePerRun},
+    {"writeBinaryModel", USES_SIZE | USES_TEMPLATES, NULL, runWriteBinaryModel, onePerRun},
+    {"readBinaryModel", USES_SIZE | USES_TEMPLATES, NULL, runReadBinaryModel, onePerRun}
+};
+
+static const int numKernels = sizeof(kernels) / sizeof(kernels[0]);
+
+static void initFixture(Fixture *f, int width, int height, unsigned seed)
+{
+    SyntheticSequence sequence(width, height, 2, benchScenarios[0], seed);
+
+    f->img0.create(height, width, CV_8UC1);
+    f->img1.create(height, width, CV_8UC1);
+    sequence.render(0, f->img0);
+    sequence.render(1, f->img1);
+    f->ipl0 = f->img0;
+    f->ipl1 = f->img1;
+
+    Mat diff;
+    absdiff(f->img0, f->img1, diff);
+    threshold(diff, f->foreground, 16, 255, CV_THRESH_BINARY);
+
+    srand(seed);
+    f->tld = new TLD();
+
+    if(cascade(f) == NULL)
+    {
+        printf("Error: The micro benchmarks need the CPU detector cascade\n");
+        exit(EXIT_FAILURE);
+    }
+
+    f->tld->detectorCascade->setImgSize(width, height, f->img0.step);
+
+    Rect bb = sequence.groundTruth(0);
+    f->tld->selectObject(f->img0, &bb);
+    f->object = bb;
+
+    f->integral = new IntegralImage<int>(f->img0.size());
+    f->integralSquared = new IntegralImage<long long>(f->img0.size());
+
+    tldExtractNormalizedPatchRect(f->img0, &bb, f->patch.values);
+
+    f->bb[0] = bb.x;
+    f->bb[1] = bb.y;
+    f->bb[2] = bb.x + bb.width - 1;
+    f->bb[3] = bb.y + bb.height - 1;
+    getFilledBBPoints(f->bb, 10, 10, 5, f->points);
+
+    for(int i = 0; i < MICROBENCH_POINTS; i++)
+    {
+        f->pt0[i].x = f->points[2 * i];
+        f->pt0[i].y = f->points[2 * i + 1];
+        f->pt1[i].x = f->pt0[i].x + 2 + (i % 3) * 0.1f;
+        f->pt1[i].y = f->pt0[i].y + 1 - (i % 5) * 0.1f;
+    }
+
+    //Windows closest to the object first, as the confident windows of a real frame
+    DetectorCascade *c = cascade(f);
+    vector<pair<float, int> > overlaps(c->numWindows);
+
+    for(int i = 0; i < c->numWindows; i++)
+    {
+        int window[TLD_WINDOW_SIZE];
+        c->windowGrid.window(i, window);
+        overlaps[i] = make_pair(-tldOverlapRectRect(Rect(window[0], window[1], window[2], window[3]), bb), i);
+    }
+
+    sort(overlaps.begin(), overlaps.end());
+    f->windowsByOverlap.resize(overlaps.size());
+
+    for(size_t i = 0; i < overlaps.size(); i++)
+    {
+        f->windowsByOverlap[i] = overlaps[i].second;
+    }
+
+    char path[256];
+    sprintf(path, "%s/tld_microbench_%d", P_tmpdir, (int) getpid());
+    f->textModelPath = string(path) + ".txt";
+    f->binaryModelPath = string(path) + ".bin";
+
+    f->numWindows = f->numTemplates = f->numConfident = -1;
+}
+
+static void releaseFixture(Fixture *f)
+{
+    delete f->tld;
+    delete f->integral;
+    delete f->integralSquared;
+    unlink(f->textModelPath.c_str());
+    unlink(f->binaryModelPath.c_str());
+}
+
+//Windows spread evenly over all scales
+static void setWindows(Fixture *f, int numWindows)
+{
+    int total = cascade(f)->numWindows;
+    f->windowIndices.resize(numWindows);
+
+    for(int i = 0; i < numWindows; i++)
+    {
+        f->windowIndices[i] = (numWindows <= total) ? (int)((long long) i * total / numWindows) : i % total;
+    }
+
+    f->numWindows = numWindows;
+}
+
+//Templates are patches of windows spread over the image
+static void setTemplates(Fixture *f, int numTemplates)
+{
+    INNClassifier *nn = f->tld->nnClassifier;
+    DetectorCascade *c = cascade(f);
+    NormalizedPatch patch;
+
+    nn->truePositives->clear();
+    nn->falsePositives->clear();
+
+    for(int i = 0; i < 2 * numTemplates; i++)
+    {
+        int windowIdx = (int)((long long) i * c->numWindows / (2 * numTemplates));
+        int window[TLD_WINDOW_SIZE];
+        c->windowGrid.window(windowIdx, window);
+        tldExtractNormalizedPatchBB(f->img0, window, patch.values);
+        patch.positive = (i % 2 == 0);
+        (patch.positive) ? nn->truePositives->push_back(patch) : nn->falsePositives->push_back(patch);
+    }
+
+    f->tld->writeToFile(f->textModelPath.c_str());
+    f->tld->writeToBinaryFile(f->binaryModelPath.c_str());
+
+    f->numTemplates = numTemplates;
+}
+
+static void setConfident(Fixture *f, int numConfident)
+{
+    int n = min<int>(numConfident, f->windowsByOverlap.size());
+    f->confidentIndices.assign(f->windowsByOverlap.begin(), f->windowsByOverlap.begin() + n);
+    f->numConfident = numConfident;
+}
+
+struct Measurement
+{
+    string kernel;
+    int width;
+    int height;
+    int numWindows;
+    int numTemplates;
+    int numConfident;
+    int iterations;
+    int items;
+    double median; //Nanoseconds per run
+    double min;
+};
+
+static Measurement measure(const Kernel &kernel, Fixture *f, double minTime, int repeats)
+{
+    if(kernel.setUp != NULL)
+    {
+        kernel.setUp(f);
+    }
+
+    //Warm up and calibrate
+    uint64_t begin = benchNow();
+    kernel.run(f);
+    double single = max<double>(benchNow() - begin, 1);
+    int iterations = max(1, (int)(minTime * 1e9 / repeats / single));
+
+    vector<double> times;
+
+    for(int r = 0; r < repeats; r++)
+    {
+        begin = benchNow();
+
+        for(int i = 0; i < iterations; i++)
+        {
+            kernel.run(f);
+        }
+
+        times.push_back((double)(benchNow() - begin) / iterations);
+    }
+
+    sort(times.begin(), times.end());
+
+    Measurement m;
+    m.kernel = kernel.name;
+    m.width = (kernel.params & USES_SIZE) ? f->img0.cols : 0;
+    m.height = (kernel.params & USES_SIZE) ? f->img0.rows : 0;
+    m.numWindows = (kernel.params & USES_WINDOWS) ? f->numWindows : 0;
+    m.numTemplates = (kernel.params & USES_TEMPLATES) ? f->numTemplates : 0;
+    m.numConfident = (kernel.params & USES_CONFIDENT) ? f->numConfident : 0;
+    m.iterations = iterations;
+    m.items = kernel.items(f);
+    m.median = benchPercentile(times, 0.5);
+    m.min = times[0];
+
+    return m;
+}
+
+/*
+ * Checks the SSE2 update of the running average background against the
+ * scalar code on random rows. Returns the number of differing rows.
+ */
+static int checkUpdateAverageRow(int numRows)
+{
+    const int maxWidth = 100;
+    uchar img[maxWidth];
+    short average[maxWidth];
+    short averageScalar[maxWidth];
+    uchar foreground[maxWidth];
+    uchar foregroundScalar[maxWidth];
+    int numDifferent = 0;
+
+    for(int i = 0; i < numRows; i++)
+    {
+        int width = 1 + rand() % maxWidth;
+        int threshold = rand() % 256;
+        int shift = rand() % 8;
+
+        for(int x = 0; x < width; x++)
+        {
+            img[x] = rand() % 256;
+            average[x] = averageScalar[x] = rand() % (255 * 128 + 1);
+        }
+
+        tldUpdateAverageRow(img, average, foreground, width, threshold, shift, true);
+        tldUpdateAverageRow(img, averageScalar, foregroundScalar, width, threshold, shift, false);
+
+        if(memcmp(average, averageScalar, width * sizeof(short)) != 0 || memcmp(foreground, foregroundScalar, width) != 0)
+        {
+            if(numDifferent == 0) printf("  updateAverageRow: width %d, threshold %d, shift %d differs\n", width, threshold, shift);
+
+            numDifferent++;
+        }
+    }
+
+    return numDifferent;
+}
+
+//8-connected flood fill, the reference for ConnectedComponents
+static void floodFillComponents(const Mat &img, int minArea, vector<Rect> &boxes, vector<int> &areas)
+{
+    Mat visited = Mat::zeros(img.rows, img.cols, CV_8UC1);
+    vector<Point> stack;
+
+    boxes.clear();
+    areas.clear();
+
+    for(int y = 0; y < img.rows; y++)
+    {
+        for(int x = 0; x < img.cols; x++)
+        {
+            if(img.at<uchar>(y, x) == 0 || visited.at<uchar>(y, x)) continue;
+
+            int x1 = x, y1 = y, x2 = x, y2 = y;
+            int area = 0;
+            visited.at<uchar>(y, x) = 1;
+            stack.push_back(Point(x, y));
+
+            while(!stack.empty())
+            {
+                Point p = stack.back();
+                stack.pop_back();
+                area++;
+                x1 = min(x1, p.x);
+                y1 = min(y1, p.y);
+                x2 = max(x2, p.x);
+                y2 = max(y2, p.y);
+
+                for(int ny = max(p.y - 1, 0); ny <= min(p.y + 1, img.rows - 1); ny++)
+                {
+                    for(int nx = max(p.x - 1, 0); nx <= min(p.x + 1, img.cols - 1); nx++)
+                    {
+                        if(img.at<uchar>(ny, nx) == 0 || visited.at<uchar>(ny, nx)) continue;
+
+                        visited.at<uchar>(ny, nx) = 1;
+                        stack.push_back(Point(nx, ny));
+                    }
+                }
+            }
+
+            if(area < minArea) continue;
+
+            boxes.push_back(Rect(x1, y1, x2 - x1 + 1, y2 - y1 + 1));
+            areas.push_back(area);
+        }
+    }
+}
+
+/*
+ * Labels random binary images with ConnectedComponents and with a flood
+ * fill. Both number the components in the order of their first pixel, so
+ * the lists of bounding boxes and areas must be equal. Returns the number of
+ * differing images.
+ */
+static int checkConnectedComponents(int numImages)
+{
+    ConnectedComponents components;
+    vector<Rect> boxes;
+    vector<int> areas;
+    int numDifferent = 0;
+
+    for(int i = 0; i < numImages; i++)
+    {
+        //Widths beyond 16 pixels exercise the SSE2 scan of the rows
+        Mat img(1 + rand() % 64, 1 + rand() % 64, CV_8UC1);
+        int density = rand() % 100;
+        int minArea = rand() % 4;
+
+        for(int y = 0; y < img.rows; y++)
+        {
+            for(int x = 0; x < img.cols; x++)
+            {
+                img.at<uchar>(y, x) = (rand() % 100 < density) ? 1 + rand() % 255 : 0;
+            }
+        }
+
+        components.label(img, minArea);
+        floodFillComponents(img, minArea, boxes, areas);
+
+        if(components.boxes != boxes || components.areas != areas)
+        {
+            if(numDifferent == 0) printf("  connectedComponents: %dx%d image with %d%% foreground differs, %d components instead of %d\n",
+                                             img.cols, img.rows, density, (int) components.boxes.size(), (int) boxes.size());
+
+            numDifferent++;
+        }
+    }
+
+    return numDifferent;
+}
+
+//Runs the checks of -V and returns the number of failed ones
+static int verifyKernels(unsigned seed)
+{
+    int numFailed = 0;
+    int numDifferent;
+
+    srand(seed);
+
+#ifdef __SSE2__
+    numDifferent = checkUpdateAverageRow(10000);
+    printf("%s: updateAverageRow, SSE2 against scalar, %d of 10000 random rows differ\n", (numDifferent > 0) ? "FAIL" : "PASS", numDifferent);
+    numFailed += numDifferent > 0;
+#else
+    printf("SKIP: updateAverageRow, built without SSE2\n");
+#endif
+
+    numDifferent = checkConnectedComponents(2000);
+    printf("%s: connectedComponents, against a flood fill, %d of 2000 random images differ\n", (numDifferent > 0) ? "FAIL" : "PASS", numDifferent);
+    numFailed += numDifferent > 0;
+
+    return numFailed;
+}
+
+static void usage()
+{
+    printf("Usage: tld_microbench [-r <width>x<height>]... [-w <windows>]... [-t <templates>]... [-p <confident>]...\n");
+    printf("                      [-k <kernel>]... [-T <seconds>] [-R <repeats>] [-e <seed>] [-j <json>] [-c <csv>]\n");
+    printf("       tld_microbench -V [-e <seed>]\n");
+    printf("  -r  image size (default 320x240, 640x480, 1280x720)\n");
+    printf("  -w  windows per run of the window kernels (default 1000, 10000)\n");
+    printf("  -t  number of positive and of negative templates (default 10, 100)\n");
+    printf("  -p  number of confident windows to cluster (default 16, 64)\n");
+    printf("  -k  kernel, may be repeated (default all):");
+
+    for(int i = 0; i < numKernels; i++)
+    {
+        printf(" %s", kernels[i].name);
+    }
+
+    printf("\n  -T  minimum time per measurement in seconds (default 0.2)\n");
+    printf("  -R  repetitions per measurement, the median is reported (default 5)\n");
+    printf("  -e  seed (default 0)\n");
+    printf("  -j  write results as JSON\n");
+    printf("  -c  write results as CSV\n");
+    printf("  -V  check the optimized kernels against reference implementations instead of timing them\n");
+}
+
+static bool parseList(const char *arg, vector<int> &list)
+{
+    int value = atoi(arg);
+
+    if(value <= 0)
+    {
+        printf("Error: Invalid value: %s\n", arg);
+        return false;
+    }
+
+    list.push_back(value);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    vector<Size> sizes;
+    vector<int> windowCounts;
+    vector<int> templateCounts;
+    vector<int> confidentCounts;
+    vector<const Kernel *> selected;
+    double minTime = 0.2;
+    int repeats = 5;
+    unsigned seed = 0;
+    const char *jsonPath = NULL;
+    const char *csvPath = NULL;
+    bool verify = false;
+
+    int c;
+
+    while((c = getopt(argc, argv, "r:w:t:p:k:T:R:e:j:c:Vh")) != -1)
+    {
+        switch(c)
+        {
+        case 'r':
+        {
+            int w, h;
+
+            if(sscanf(optarg, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            {
+                printf("Error: Invalid size: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            sizes.push_back(Size(w, h));
+            break;
+        }
+        case 'w':
+            if(!parseList(optarg, windowCounts)) return EXIT_FAILURE;
+
+            break;
+        case 't':
+            if(!parseList(optarg, templateCounts)) return EXIT_FAILURE;
+
+            break;
+        case 'p':
+            if(!parseList(optarg, confidentCounts)) return EXIT_FAILURE;
+
+            break;
+        case 'k':
+        {
+            const Kernel *kernel = NULL;
+
+            for(int i = 0; i < numKernels; i++)
+            {
+                if(string(optarg) == kernels[i].name) kernel = &kernels[i];
+            }
+
+            if(kernel == NULL)
+            {
+                printf("Error: Unknown kernel: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            selected.push_back(kernel);
+            break;
+        }
+        case 'T':
+            minTime = atof(optarg);
+            break;
+        case 'R':
+            repeats = max(1, atoi(optarg));
+            break;
+        case 'e':
+            seed = atoi(optarg);
+            break;
+        case 'j':
+            jsonPath = optarg;
+            break;
+        case 'c':
+            csvPath = optarg;
+            break;
+        case 'V':
+            verify = true;
+            break;
+        default:
+            usage();
+            return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if(verify)
+    {
+        return (verifyKernels(seed) > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    if(sizes.empty())
+    {
+        sizes.push_back(Size(320, 240));
+        sizes.push_back(Size(640, 480));
+        sizes.push_back(Size(1280, 720));
+    }
+
+    if(windowCounts.empty())
+    {
+        windowCounts.push_back(1000);
+        windowCounts.push_back(10000);
+    }
+
+    if(templateCounts.empty())
+    {
+        templateCounts.push_back(10);
+        templateCounts.push_back(100);
+    }
+
+    if(confidentCounts.empty())
+    {
+        confidentCounts.push_back(16);
+        confidentCounts.push_back(64);
+    }
+
+    if(selected.empty())
+    {
+        for(int i = 0; i < numKernels; i++)
+        {
+            selected.push_back(&kernels[i]);
+        }
+    }
+
+    vector<Measurement> results;
+
+    printf("%-24s %10s %8s %9s %9s %10s %14s %14s %12s\n", "kernel", "size", "windows", "templates", "confident", "iterations", "median ns/run", "min ns/run", "ns/item");
+
+    for(size_t s = 0; s < sizes.size(); s++)
+    {
+        Fixture fixture;
+        initFixture(&fixture, sizes[s].width, sizes[s].height, seed);
+
+        for(size_t k = 0; k < selected.size(); k++)
+        {
+            const Kernel &kernel = *selected[k];
+
+            //Kernels that do not depend on the image size run for the first size only
+            if(!(kernel.params & USES_SIZE) && s > 0)
+            {
+                continue;
+            }
+
+            vector<int> windows = (kernel.params & USES_WINDOWS) ? windowCounts : vector<int>(1, 1000);
+            vector<int> templates = (kernel.params & USES_TEMPLATES) ? templateCounts : vector<int>(1, 10);
+            vector<int> confident = (kernel.params & USES_CONFIDENT) ? confidentCounts : vector<int>(1, 16);
+
+            for(size_t w = 0; w < windows.size(); w++)
+            {
+                for(size_t t = 0; t < templates.size(); t++)
+                {
+                    for(size_t p = 0; p < confident.size(); p++)
+                    {
+                        if(fixture.numWindows != windows[w]) setWindows(&fixture, windows[w]);
+
+                        if(fixture.numTemplates != templates[t]) setTemplates(&fixture, templates[t]);
+
+                        if(fixture.numConfident != confident[p]) setConfident(&fixture, confident[p]);
+
+                        Measurement m = measure(kernel, &fixture, minTime, repeats);
+                        results.push_back(m);
+
+                        char size[32];
+                        sprintf(size, "%dx%d", m.width, m.height);
+                        printf("%-24s %10s %8d %9d %9d %10d %14.1f %14.1f %12.2f\n", m.kernel.c_str(), size, m.numWindows, m.numTemplates,
+                               m.numConfident, m.iterations, m.median, m.min, m.median / max(1, m.items));
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+
+        releaseFixture(&fixture);
+    }
+
+    if(jsonPath != NULL)
+    {
+        FILE *file = fopen(jsonPath, "w");
+
+        if(file == NULL)
+        {
+            printf("Error: Unable to write %s\n", jsonPath);
+            return EXIT_FAILURE;
+        }
+
+        fprintf(file, "{\"results\": [\n");
+
+        for(size_t i = 0; i < results.size(); i++)
+        {
+            const Measurement &m = results[i];
+            fprintf(file, "{\"kernel\": \"%s\", \"width\": %d, \"height\": %d, \"windows\": %d, \"templates\": %d, \"confident\": %d, "
+                    "\"iterations\": %d, \"items\": %d, \"median_ns\": %.1f, \"min_ns\": %.1f, \"ns_per_item\": %.3f}%s\n",
+                    m.kernel.c_str(), m.width, m.height, m.numWindows, m.numTemplates, m.numConfident, m.iterations, m.items,
+                    m.median, m.min, m.median / max(1, m.items), (i + 1 < results.size()) ? "," : "");
+        }
+
+        fprintf(file, "]}\n");
+        fclose(file);
+    }
+
+    if(csvPath != NULL)
+    {
+        FILE *file = fopen(csvPath, "w");
+
+        if(file == NULL)
+        {
+            printf("Error: Unable to write %s\n", csvPath);
+            return EXIT_FAILURE;
+        }
+
+        fprintf(file, "kernel,width,height,windows,templates,confident,iterations,items,median_ns,min_ns,ns_per_item\n");
+
+        for(size_t i = 0; i < results.size(); i++)
+        {
+            const Measurement &m = results[i];
+            fprintf(file, "%s,%d,%d,%d,%d,%d,%d,%d,%.1f,%.1f,%.3f\n", m.kernel.c_str(), m.width, m.height, m.numWindows,
+                    m.numTemplates, m.numConfident, m.iterations, m.items, m.median, m.min, m.median / max(1, m.items));
+        }
+
+        fclose(file);
+    }
+
+    return EXIT_SUCCESS;
+}
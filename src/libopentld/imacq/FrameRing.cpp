@@ -0,0 +1,292 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * FrameRing.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "FrameRing.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+static const char FRAMERING_MAGIC[8] = {'T', 'L', 'D', 'R', 'I', 'N', 'G', '\0'};
+
+static size_t frameRingAlign(size_t size)
+{
+    return (size + FRAMERING_ALIGNMENT - 1) & ~(size_t)(FRAMERING_ALIGNMENT - 1);
+}
+
+//Waits until *address differs from value, is woken, or the timeout expires
+static void frameRingWait(volatile uint32_t *address, uint32_t value, int timeoutMs)
+{
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    //Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    syscall(SYS_futex, address, FUTEX_WAIT, value, (timeoutMs < 0) ? NULL : &timeout, NULL, 0);
+#elif !defined(_WIN32) //Rings cannot be opened on Windows
+
+    if(*address == value) usleep(1000);
+
+#endif
+}
+
+static void frameRingWake(volatile uint32_t *address)
+{
+    __sync_fetch_and_add(address, 1);
+#ifdef __linux__
+    syscall(SYS_futex, address, FUTEX_WAKE, 0x7fffffff, NULL, NULL, 0);
+#endif
+}
+
+#ifndef _WIN32
+
+//Only the producer may write; consumers map the ring read-only
+static FrameRing *frameRingMap(const char *name, int fd, size_t size, int owner)
+{
+    void *map = mmap(NULL, size, owner ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED)
+    {
+        printf("Error: Unable to map the frame ring %s\n", name);
+        return NULL;
+    }
+
+    FrameRing *ring = (FrameRing *) malloc(sizeof(FrameRing));
+    ring->map = map;
+    ring->size = size;
+    ring->header = (FrameRingHeader *) map;
+    ring->slots = (FrameRingSlot *)((char *) map + frameRingAlign(sizeof(FrameRingHeader)));
+    ring->name = strdup(name);
+    ring->owner = owner;
+    ring->nextSeq = 1;
+    ring->numDropped = 0;
+    return ring;
+}
+
+FrameRing *frameRingCreate(const char *name, int width, int height, int channels, int numSlots)
+{
+    if(width <= 0 || height <= 0 || (channels != 1 && channels != 3) || numSlots < 2)
+    {
+        printf("Error: Invalid frame ring format\n");
+        return NULL;
+    }
+
+    size_t step = (size_t) width * channels;
+    size_t slotSize = frameRingAlign(step * height);
+    size_t dataOffset = frameRingAlign(frameRingAlign(sizeof(FrameRingHeader)) + numSlots * sizeof(FrameRingSlot));
+    size_t size = dataOffset + numSlots * slotSize;
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if(fd < 0 || ftruncate(fd, size) != 0)
+    {
+        printf("Error: Unable to create the frame ring %s: %s\n", name, strerror(errno));
+
+        if(fd >= 0) close(fd);
+
+        return NULL;
+    }
+
+    FrameRing *ring = frameRingMap(name, fd, size, 1);
+
+    if(ring == NULL) return NULL;
+
+    FrameRingHeader *header = ring->header;
+    header->version = FRAMERING_VERSION;
+    header->numSlots = numSlots;
+    header->width = width;
+    header->height = height;
+    header->channels = channels;
+    header->step = step;
+    header->slotSize = slotSize;
+    header->dataOffset = dataOffset;
+    header->lastSeq = 0;
+    header->futex = 0;
+    header->closed = 0;
+
+    //Consumers check the magic last
+    __sync_synchronize();
+    memcpy(header->magic, FRAMERING_MAGIC, sizeof(FRAMERING_MAGIC));
+
+    return ring;
+}
+
+FrameRing *frameRingOpen(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    struct stat st;
+
+    if(fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(FrameRingHeader))
+    {
+        printf("Error: Unable to open the frame ring %s\n", name);
+
+        if(fd >= 0) close(fd);
+
+        return NULL;
+    }
+
+    FrameRing *ring = frameRingMap(name, fd, st.st_size, 0);
+
+    if(ring == NULL) return NULL;
+
+    FrameRingHeader *header = ring->header;
+
+    if(memcmp(header->magic, FRAMERING_MAGIC, sizeof(FRAMERING_MAGIC)) != 0 || header->version != FRAMERING_VERSION
+            || header->dataOffset + header->numSlots * header->slotSize > ring->size)
+    {
+        printf("Error: %s is not a frame ring of version %d\n", name, FRAMERING_VERSION);
+        frameRingClose(ring);
+        return NULL;
+    }
+
+    ring->nextSeq = header->lastSeq + 1; //Live: start with the next frame
+    return ring;
+}
+
+void frameRingClose(FrameRing *ring)
+{
+    if(ring == NULL) return;
+
+    munmap(ring->map, ring->size);
+
+    if(ring->owner) shm_unlink(ring->name);
+
+    free(ring->name);
+    free(ring);
+}
+
+#else
+
+//There is no POSIX shared memory; rings are neither created nor opened
+FrameRing *frameRingCreate(const char *name, int, int, int, int)
+{
+    printf("Error: Unable to create the frame ring %s: shared memory rings are not supported on Windows\n", name);
+    return NULL;
+}
+
+FrameRing *frameRingOpen(const char *name)
+{
+    printf("Error: Unable to open the frame ring %s: shared memory rings are not supported on Windows\n", name);
+    return NULL;
+}
+
+void frameRingClose(FrameRing *ring)
+{
+}
+
+#endif
+
+char *frameRingBeginWrite(FrameRing *ring)
+{
+    FrameRingHeader *header = ring->header;
+    uint64_t seq = ring->nextSeq;
+    int slot = seq % header->numSlots;
+
+    ring->slots[slot].seq = 0; //Readers of the frame that was here see it is gone
+    __sync_synchronize();
+
+    return (char *) ring->map + header->dataOffset + slot * header->slotSize;
+}
+
+void frameRingPublish(FrameRing *ring, int64_t timestamp)
+{
+    FrameRingHeader *header = ring->header;
+    uint64_t seq = ring->nextSeq++;
+    FrameRingSlot *slot = &ring->slots[seq % header->numSlots];
+
+    slot->timestamp = timestamp;
+    __sync_synchronize(); //The frame is complete before its number appears
+    slot->seq = seq;
+    header->lastSeq = seq;
+    frameRingWake(&header->futex);
+}
+
+void frameRingShutdown(FrameRing *ring)
+{
+    ring->header->closed = 1;
+    frameRingWake(&ring->header->futex);
+}
+
+const char *frameRingNext(FrameRing *ring, uint64_t *seq, int timeoutMs)
+{
+    FrameRingHeader *header = ring->header;
+
+    while(1)
+    {
+        uint32_t futex = header->futex;
+        __sync_synchronize();
+        uint64_t lastSeq = header->lastSeq;
+
+        if(lastSeq >= ring->nextSeq)
+        {
+            //Overwritten frames are skipped; one slot is kept as margin for the writer
+            if(lastSeq - ring->nextSeq >= header->numSlots - 1)
+            {
+                ring->numDropped += lastSeq - ring->nextSeq;
+                ring->nextSeq = lastSeq;
+            }
+
+            uint64_t next = ring->nextSeq;
+            FrameRingSlot *slot = &ring->slots[next % header->numSlots];
+
+            if(slot->seq != next) continue; //Overwritten meanwhile
+
+            __sync_synchronize();
+            ring->nextSeq = next + 1;
+            *seq = next;
+            return (const char *) ring->map + header->dataOffset + (next % header->numSlots) * header->slotSize;
+        }
+
+        if(header->closed) return NULL;
+
+        if(timeoutMs == 0) return NULL;
+
+        frameRingWait(&header->futex, futex, timeoutMs);
+
+        if(timeoutMs > 0 && header->futex == futex) return NULL; //Timed out
+    }
+}
+
+int frameRingIsValid(FrameRing *ring, uint64_t seq)
+{
+    __sync_synchronize();
+    return ring->slots[seq % ring->header->numSlots].seq == seq;
+}
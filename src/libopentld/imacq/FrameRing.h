@@ -0,0 +1,110 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * FrameRing.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef FRAMERING_H_
+#define FRAMERING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAMERING_VERSION 1
+#define FRAMERING_ALIGNMENT 64
+
+/**
+ * A ring of frames in POSIX shared memory (shm_open), written by one
+ * producer and read by any number of consumers. Frames are numbered from 1.
+ * The producer writes frame n into slot n % numSlots and never waits for
+ * consumers; a consumer that falls behind by more than numSlots - 1 frames
+ * skips to the newest one. Consumers block on a futex in the header that the
+ * producer increments and wakes after every frame.
+ *
+ * Layout: FrameRingHeader, numSlots * FrameRingSlot, then numSlots frames of
+ * slotSize bytes, each starting at a multiple of FRAMERING_ALIGNMENT.
+ */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numSlots;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels; //!< 1: greyscale, 3: BGR
+    uint32_t step; //!< Bytes per row
+    uint64_t slotSize;
+    uint64_t dataOffset;
+    volatile uint64_t lastSeq; //!< Number of the newest complete frame, 0 if none
+    volatile uint32_t futex; //!< Incremented after every frame and at shutdown
+    volatile uint32_t closed; //!< Set by the producer when no more frames follow
+} FrameRingHeader;
+
+typedef struct
+{
+    volatile uint64_t seq; //!< Number of the frame in the slot, 0 while it is being written
+    int64_t timestamp; //!< Microseconds, as given by the producer
+} FrameRingSlot;
+
+typedef struct
+{
+    void *map;
+    size_t size;
+    FrameRingHeader *header;
+    FrameRingSlot *slots;
+    char *name;
+    int owner; //!< Created by this process, which unlinks it
+    uint64_t nextSeq; //!< Next frame written (producer) or wanted (consumer)
+    uint64_t numDropped; //!< Frames a consumer skipped because it was too slow
+} FrameRing;
+
+/**
+ * Creates the ring (replacing one of the same name) for the producer.
+ */
+FrameRing *frameRingCreate(const char *name, int width, int height, int channels, int numSlots);
+
+/**
+ * Attaches a consumer to an existing ring. It starts at the newest frame.
+ */
+FrameRing *frameRingOpen(const char *name);
+
+void frameRingClose(FrameRing *ring);
+
+/**
+ * Producer: returns the memory for the next frame, then publish it.
+ */
+char *frameRingBeginWrite(FrameRing *ring);
+void frameRingPublish(FrameRing *ring, int64_t timestamp);
+void frameRingShutdown(FrameRing *ring);
+
+/**
+ * Consumer: waits up to timeoutMs (-1: forever) for the next frame.
+ * Returns its data, valid in place until the producer wraps around to its
+ * slot, or NULL on timeout or when the producer has shut down.
+ */
+const char *frameRingNext(FrameRing *ring, uint64_t *seq, int timeoutMs);
+
+/**
+ * Consumer: whether frame seq is still in its slot, i.e. was not overwritten.
+ */
+int frameRingIsValid(FrameRing *ring, uint64_t seq);
+
+#endif /* FRAMERING_H_ */
@@ -19,7 +19,25 @@
 
 #include "ImAcq.h"
 
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define STDIN_FILENO 0
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0 //Only Windows distinguishes text and binary files
+#endif
 
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
@@ -33,9 +51,313 @@ ImAcq *imAcqAlloc() {
     imAcq->lastFrame = 0;
     imAcq->camNo = 0;
     imAcq->fps = 24;
+    imAcq->width = 0;
+    imAcq->height = 0;
+    imAcq->channels = 1;
+    imAcq->pipeFd = -1;
+    imAcq->rawData = NULL;
+    imAcq->rawSize = 0;
+    imAcq->rawOffsets = NULL;
+    imAcq->rawNumFrames = 0;
+    imAcq->rawFrame = NULL;
+    imAcq->ring = NULL;
+    imAcq->ringSeq = 0;
+    imAcq->decoderThreads = 0;
+    imAcq->readAhead = 16;
+    imAcq->decoder = NULL;
+
+    for (int i = 0; i < IMACQ_POOL_SIZE; i++) {
+        imAcq->pool[i] = NULL;
+        imAcq->poolInUse[i] = 0;
+    }
+
+    imAcq->borrowed = NULL;
+    imAcq->grey = NULL;
     return imAcq;
 }
 
+/*
+ * Size of the chroma planes of a Y4M frame, -1 if the colour space is not
+ * supported. Only 8 bit samples are supported.
+ */
+static long imAcqY4MChromaSize(const char *colourSpace, int w, int h) {
+    long cw = (w + 1) / 2;
+    long ch = (h + 1) / 2;
+
+    //420jpeg, 420paldv, 420mpeg2 and 420 only differ in chroma siting
+    if (strcmp(colourSpace, "420jpeg") == 0 || strcmp(colourSpace, "420paldv") == 0
+            || strcmp(colourSpace, "420mpeg2") == 0 || strcmp(colourSpace, "420") == 0) return 2 * cw * ch;
+
+    if (strcmp(colourSpace, "422") == 0) return 2 * cw * h;
+
+    if (strcmp(colourSpace, "444") == 0) return 2L * w * h;
+
+    if (strcmp(colourSpace, "444alpha") == 0) return 3L * w * h;
+
+    if (strcmp(colourSpace, "mono") == 0) return 0;
+
+    return -1;
+}
+
+/*
+ * Maps the file and finds the frames. A file starting with "YUV4MPEG2 " is
+ * read as Y4M, of which only the luma plane is used; anything else as
+ * headerless 8 bit greyscale frames of imAcq->width x imAcq->height.
+ */
+static int imAcqRawOpen(ImAcq *imAcq) {
+    int fd = open(imAcq->imgPath, O_RDONLY | O_BINARY);
+
+    if (fd < 0) {
+        printf("Error: Unable to open %s\n", imAcq->imgPath);
+        return 0;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("Error: %s is empty\n", imAcq->imgPath);
+        close(fd);
+        return 0;
+    }
+
+#ifdef _WIN32
+    //Without mmap, the whole file is read into memory
+    char *data = (char *) malloc(st.st_size);
+    long size = 0;
+
+    while (data != NULL && size < st.st_size) {
+        int n = read(fd, data + size, st.st_size - size);
+
+        if (n <= 0) break;
+
+        size += n;
+    }
+
+    close(fd);
+
+    if (data == NULL || size < st.st_size) {
+        printf("Error: Unable to read %s\n", imAcq->imgPath);
+        free(data);
+        return 0;
+    }
+
+#else
+    //Private and writable, so drawing into a frame copies only the touched pages
+    void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        printf("Error: Unable to map %s\n", imAcq->imgPath);
+        return 0;
+    }
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    imAcq->rawData = (char *) data;
+    imAcq->rawSize = st.st_size;
+
+    size_t pos = 0;
+    long frameSize;
+    long chromaSize = 0;
+    int isY4M = imAcq->rawSize > 10 && memcmp(imAcq->rawData, "YUV4MPEG2 ", 10) == 0;
+
+    if (isY4M) {
+        char *end = (char *) memchr(imAcq->rawData, '\n', imAcq->rawSize);
+
+        if (end == NULL || end - imAcq->rawData > 1023) {
+            printf("Error: Invalid Y4M header in %s\n", imAcq->imgPath);
+            return 0;
+        }
+
+        char header[1024];
+        memcpy(header, imAcq->rawData, end - imAcq->rawData);
+        header[end - imAcq->rawData] = '\0';
+
+        const char *colourSpace = "420"; //The default of the format
+        imAcq->width = imAcq->height = 0;
+
+        for (char *token = strtok(header + 10, " "); token != NULL; token = strtok(NULL, " ")) {
+            if (token[0] == 'W') imAcq->width = atoi(token + 1);
+            else if (token[0] == 'H') imAcq->height = atoi(token + 1);
+            else if (token[0] == 'C') colourSpace = token + 1;
+        }
+
+        chromaSize = imAcqY4MChromaSize(colourSpace, imAcq->width, imAcq->height);
+
+        if (chromaSize < 0) {
+            printf("Error: Unsupported Y4M colour space %s in %s\n", colourSpace, imAcq->imgPath);
+            return 0;
+        }
+
+        pos = end - imAcq->rawData + 1;
+    }
+
+    if (imAcq->width <= 0 || imAcq->height <= 0) {
+        printf("Error: The frame size of %s is unknown; set width and height\n", imAcq->imgPath);
+        return 0;
+    }
+
+    frameSize = (long) imAcq->width * imAcq->height;
+
+    int capacity = 1024;
+    imAcq->rawOffsets = (size_t *) malloc(capacity * sizeof(size_t));
+    imAcq->rawNumFrames = 0;
+
+    while (pos < imAcq->rawSize) {
+        if (isY4M) {
+            //Every frame starts with a line "FRAME[ parameters]"
+            char *end = (char *) memchr(imAcq->rawData + pos, '\n', imAcq->rawSize - pos);
+
+            if (end == NULL || memcmp(imAcq->rawData + pos, "FRAME", 5) != 0) break;
+
+            pos = end - imAcq->rawData + 1;
+        }
+
+        if (pos + frameSize > imAcq->rawSize) break; //Truncated
+
+        if (imAcq->rawNumFrames == capacity) {
+            capacity *= 2;
+            imAcq->rawOffsets = (size_t *) realloc(imAcq->rawOffsets, capacity * sizeof(size_t));
+        }
+
+        imAcq->rawOffsets[imAcq->rawNumFrames++] = pos;
+        pos += frameSize + chromaSize;
+    }
+
+    if (imAcq->rawNumFrames == 0) {
+        printf("Error: %s contains no complete frame\n", imAcq->imgPath);
+        return 0;
+    }
+
+    imAcq->rawFrame = cvCreateImageHeader(cvSize(imAcq->width, imAcq->height), IPL_DEPTH_8U, 1);
+    return 1;
+}
+
+//A view into the mapping, valid until the next frame is requested
+static IplImage *imAcqLoadRawFrame(ImAcq *imAcq, int fNo) {
+    if (fNo < 1 || fNo > imAcq->rawNumFrames) return NULL;
+
+    cvSetData(imAcq->rawFrame, imAcq->rawData + imAcq->rawOffsets[fNo - 1], imAcq->width);
+    imAcq->borrowed = imAcq->rawFrame;
+    return imAcq->rawFrame;
+}
+
+static IplImage *imAcqPoolAcquire(ImAcq *imAcq, CvSize size, int depth, int channels);
+
+//Reads exactly size bytes unless the writer closes the pipe
+static int imAcqPipeRead(ImAcq *imAcq, char *data, size_t size) {
+    while (size > 0) {
+        long n = read(imAcq->pipeFd, data, size);
+
+        if (n < 0 && errno == EINTR) continue;
+
+        if (n <= 0) return 0;
+
+        data += n;
+        size -= n;
+    }
+
+    return 1;
+}
+
+//Reads the next frame into a buffer of the pool; NULL at the end of the stream
+static IplImage *imAcqLoadPipeFrame(ImAcq *imAcq) {
+    IplImage *img = imAcqPoolAcquire(imAcq, cvSize(imAcq->width, imAcq->height), IPL_DEPTH_8U, imAcq->channels);
+    int rowSize = imAcq->width * imAcq->channels;
+    int ok = 1;
+
+    if (img->widthStep == rowSize) {
+        ok = imAcqPipeRead(imAcq, img->imageData, (size_t) rowSize * imAcq->height);
+    }
+    else {
+        //Rows of the image are padded, the stream is not
+        for (int y = 0; y < imAcq->height && ok; y++) {
+            ok = imAcqPipeRead(imAcq, img->imageData + y * img->widthStep, rowSize);
+        }
+    }
+
+    if (!ok) {
+        imAcqReleaseImg(imAcq, &img);
+    }
+
+    return img;
+}
+
+static int imAcqPipeOpen(ImAcq *imAcq) {
+    if (imAcq->width <= 0 || imAcq->height <= 0 || (imAcq->channels != 1 && imAcq->channels != 3)) {
+        printf("Error: Reading from a pipe needs width, height and a format of GREY or BGR\n");
+        return 0;
+    }
+
+    if (imAcq->imgPath == NULL || strcmp(imAcq->imgPath, "-") == 0) {
+        imAcq->pipeFd = STDIN_FILENO;
+#ifdef _WIN32
+        _setmode(STDIN_FILENO, _O_BINARY);
+#endif
+    }
+    else {
+        //Blocks until a writer opens a named pipe
+        imAcq->pipeFd = open(imAcq->imgPath, O_RDONLY | O_BINARY);
+
+        if (imAcq->pipeFd < 0) {
+            printf("Error: Unable to open %s\n", imAcq->imgPath);
+            return 0;
+        }
+    }
+
+    //Frames before startFrame are skipped
+    for (int i = 1; i < imAcq->currentFrame; i++) {
+        IplImage *img = imAcqLoadPipeFrame(imAcq);
+
+        if (img == NULL) {
+            printf("Error: The stream ended before frame %d\n", imAcq->currentFrame);
+            return 0;
+        }
+
+        imAcqReleaseImg(imAcq, &img);
+    }
+
+    return 1;
+}
+
+static int imAcqRingOpen(ImAcq *imAcq) {
+    imAcq->ring = frameRingOpen(imAcq->imgPath);
+
+    if (imAcq->ring == NULL) return 0;
+
+    FrameRingHeader *header = imAcq->ring->header;
+    imAcq->width = header->width;
+    imAcq->height = header->height;
+    imAcq->channels = header->channels;
+    imAcq->rawFrame = cvCreateImageHeader(cvSize(imAcq->width, imAcq->height), IPL_DEPTH_8U, imAcq->channels);
+    return 1;
+}
+
+/*
+ * Views the next frame in place in its slot. The producer may overwrite it
+ * at any time; imAcqFrameIsValid tells whether a copy taken from it is
+ * intact. NULL once the producer has shut down.
+ */
+static IplImage *imAcqLoadRingFrame(ImAcq *imAcq) {
+    const char *data = frameRingNext(imAcq->ring, &imAcq->ringSeq, -1);
+
+    if (data == NULL) return NULL;
+
+    cvSetData(imAcq->rawFrame, (void *) data, imAcq->ring->header->step);
+    imAcq->borrowed = imAcq->rawFrame;
+    return imAcq->rawFrame;
+}
+
+int imAcqFrameIsValid(ImAcq *imAcq) {
+    if (imAcq->method != IMACQ_SHM || imAcq->ring == NULL) return 1;
+
+    if (frameRingIsValid(imAcq->ring, imAcq->ringSeq)) return 1;
+
+    imAcq->ring->numDropped++;
+    return 0;
+}
+
 void imAcqInit(ImAcq *imAcq) {
     if (imAcq->method == IMACQ_CAM) {
         imAcq->capture = cvCaptureFromCAM(imAcq->camNo);
@@ -88,6 +410,34 @@ void imAcqInit(ImAcq *imAcq) {
         //This produces strange results on some videos and is deactivated for now.
         //imAcqVidSetNextFrameNumber(imAcq, imAcq->currentFrame);
     }
+    else if (imAcq->method == IMACQ_IMGS && imAcq->decoderThreads > 0) {
+        imAcq->decoder = imAcqDecoderAlloc(imAcq->imgPath, imAcq->currentFrame, imAcq->lastFrame,
+                imAcq->decoderThreads, imAcq->readAhead);
+    }
+    else if (imAcq->method == IMACQ_SHM) {
+        if (!imAcqRingOpen(imAcq)) {
+            exit(1);
+        }
+    }
+    else if (imAcq->method == IMACQ_PIPE) {
+        if (!imAcqPipeOpen(imAcq)) {
+            exit(1);
+        }
+    }
+    else if (imAcq->method == IMACQ_RAW) {
+        if (!imAcqRawOpen(imAcq)) {
+            exit(1);
+        }
+
+        if (imAcq->lastFrame == 0)
+            imAcq->lastFrame = imAcq->rawNumFrames;
+
+        if (imAcq->lastFrame > imAcq->rawNumFrames || imAcq->currentFrame < 1 || imAcq->currentFrame > imAcq->lastFrame) {
+            printf("Error: %s has %d frames, startFrame: %d lastFrame: %d\n", imAcq->imgPath, imAcq->rawNumFrames,
+                    imAcq->currentFrame, imAcq->lastFrame);
+            exit(1);
+        }
+    }
 
     imAcq->startFrame = imAcq->currentFrame;
     imAcq->startTime = cvGetTickCount();
@@ -98,6 +448,27 @@ void imAcqFree(ImAcq *imAcq) {
         cvReleaseCapture(&imAcq->capture);
     }
 
+    for (int i = 0; i < IMACQ_POOL_SIZE; i++) {
+        if (imAcq->pool[i] != NULL) cvReleaseImage(&imAcq->pool[i]);
+    }
+
+    if (imAcq->grey != NULL) cvReleaseImage(&imAcq->grey);
+
+    if (imAcq->decoder != NULL) imAcqDecoderFree(imAcq->decoder);
+
+    if (imAcq->pipeFd > STDIN_FILENO) close(imAcq->pipeFd);
+
+    frameRingClose(imAcq->ring);
+
+#ifdef _WIN32
+    free(imAcq->rawData);
+#else
+    if (imAcq->rawData != NULL) munmap(imAcq->rawData, imAcq->rawSize);
+#endif
+
+    if (imAcq->rawFrame != NULL) cvReleaseImageHeader(&imAcq->rawFrame);
+
+    free(imAcq->rawOffsets);
     free(imAcq);
 }
 
@@ -116,12 +487,13 @@ IplImage *imAcqLoadFrame(ImAcq *imAcq, int fNo) {
     char path[255];
     sprintf(path, imAcq->imgPath, fNo);
 
-    printf("load path %s\n", path);
-
     return cvLoadImage(path);
 }
 
 IplImage *imAcqLoadCurrentFrame(ImAcq *imAcq) {
+    if (imAcq->decoder != NULL) {
+        return imAcqDecoderGet(imAcq->decoder, imAcq->currentFrame);
+    }
 
     return imAcqLoadFrame(imAcq, imAcq->currentFrame);
 }
@@ -130,7 +502,7 @@ IplImage *imAcqGetImgByCurrentTime(ImAcq *imAcq) {
     //Calculate current image number
     if (imAcq->method == IMACQ_CAM) {
         //printf("grabbing image from sensor");
-        return imAcqGrab(imAcq->capture);
+        return imAcqGrab(imAcq);
     }
 
     float secondsPassed = (cvGetTickCount() - imAcq->startTime) / cvGetTickFrequency();
@@ -150,7 +522,7 @@ IplImage *imAcqGetImg(ImAcq *imAcq) {
     IplImage *img = NULL;
 
     if (imAcq->method == IMACQ_CAM || imAcq->method == IMACQ_VID || imAcq->method == IMACQ_FILE) {
-        img = imAcqGrab(imAcq->capture);
+        img = imAcqGrab(imAcq);
     }
 
     if (imAcq->method == IMACQ_IMGS) {
@@ -161,22 +533,109 @@ IplImage *imAcqGetImg(ImAcq *imAcq) {
         img = imAcqGetImgByCurrentTime(imAcq);
     }
 
+    if (imAcq->method == IMACQ_RAW) {
+        img = imAcqLoadRawFrame(imAcq, imAcq->currentFrame);
+    }
+
+    if (imAcq->method == IMACQ_PIPE) {
+        img = imAcqLoadPipeFrame(imAcq);
+    }
+
+    if (imAcq->method == IMACQ_SHM) {
+        img = imAcqLoadRingFrame(imAcq);
+    }
+
     imAcqAdvance(imAcq);
 
     return img;
 }
 
-IplImage *imAcqGrab(CvCapture *capture) {
+/*
+ * Returns a free buffer of the pool with the given format, reallocating a
+ * free buffer of another format if necessary. If all buffers are in use, a
+ * buffer outside of the pool is allocated, which imAcqReleaseImg frees.
+ */
+static IplImage *imAcqPoolAcquire(ImAcq *imAcq, CvSize size, int depth, int channels) {
+    int freeSlot = -1;
+
+    for (int i = 0; i < IMACQ_POOL_SIZE; i++) {
+        if (imAcq->poolInUse[i]) continue;
+
+        IplImage *buffer = imAcq->pool[i];
+
+        if (buffer != NULL && buffer->width == size.width && buffer->height == size.height
+                && buffer->depth == depth && buffer->nChannels == channels) {
+            imAcq->poolInUse[i] = 1;
+            return buffer;
+        }
+
+        if (freeSlot < 0) freeSlot = i;
+    }
+
+    if (freeSlot < 0) {
+        return cvCreateImage(size, depth, channels);
+    }
+
+    if (imAcq->pool[freeSlot] != NULL) cvReleaseImage(&imAcq->pool[freeSlot]);
+
+    imAcq->pool[freeSlot] = cvCreateImage(size, depth, channels);
+    imAcq->poolInUse[freeSlot] = 1;
+    return imAcq->pool[freeSlot];
+}
+
+void imAcqReleaseImg(ImAcq *imAcq, IplImage **img) {
+    if (*img == NULL) return;
+
+    if (*img == imAcq->borrowed) {
+        imAcq->borrowed = NULL;
+        *img = NULL;
+        return;
+    }
+
+    for (int i = 0; i < IMACQ_POOL_SIZE; i++) {
+        if (imAcq->pool[i] == *img) {
+            imAcq->poolInUse[i] = 0;
+            *img = NULL;
+            return;
+        }
+    }
+
+    cvReleaseImage(img);
+}
+
+IplImage *imAcqGetGrey(ImAcq *imAcq, IplImage *img) {
+    if (img->nChannels == 1) return img;
+
+    if (imAcq->grey == NULL || imAcq->grey->width != img->width || imAcq->grey->height != img->height) {
+        if (imAcq->grey != NULL) cvReleaseImage(&imAcq->grey);
+
+        imAcq->grey = cvCreateImage(cvGetSize(img), IPL_DEPTH_8U, 1);
+    }
+
+    cvCvtColor(img, imAcq->grey, CV_BGR2GRAY);
+    return imAcq->grey;
+}
+
+IplImage *imAcqGrab(ImAcq *imAcq) {
     IplImage *frame;
 
-    frame = cvQueryFrame(capture);
+    frame = cvQueryFrame(imAcq->capture);
 
     if (frame == NULL) {
         printf("Error: Unable to grab image from video\n");
         return NULL;
     }
 
-    return cvCloneImage(frame);
+    //The capture owns frame and overwrites it on the next grab
+    if (frame->nChannels == 1 && frame->origin == 0) {
+        imAcq->borrowed = frame;
+        return frame;
+    }
+
+    IplImage *img = imAcqPoolAcquire(imAcq, cvGetSize(frame), frame->depth, frame->nChannels);
+    img->origin = frame->origin;
+    cvCopy(frame, img);
+    return img;
 }
 
 IplImage *imAcqGetImgByFrame(ImAcq *imAcq, int fNo) {
@@ -29,6 +29,9 @@
 
 #include <opencv/highgui.h>
 
+#include "FrameRing.h"
+#include "ImAcqDecoder.h"
+
 /**
  * Capturing method
  */
@@ -38,9 +41,14 @@ enum ImacqMethod
     IMACQ_CAM, //!< Camera
     IMACQ_VID, //!< Video
     IMACQ_FILE, //!< Video
-    IMACQ_LIVESIM //!< Livesim
+    IMACQ_LIVESIM, //!< Livesim
+    IMACQ_RAW, //!< Raw greyscale or Y4M file, memory mapped
+    IMACQ_PIPE, //!< Raw greyscale or BGR frames from stdin or a named pipe
+    IMACQ_SHM //!< Frames of a shared-memory FrameRing
 };
 
+#define IMACQ_POOL_SIZE 4 //!< Number of recycled frame buffers
+
 typedef struct
 {
     int method;
@@ -52,6 +60,24 @@ typedef struct
     int camNo;
     double startTime;
     float fps;
+    int width; //!< Frame width of raw files without a header
+    int height; //!< Frame height of raw files without a header
+    int channels; //!< 1 (greyscale) or 3 (BGR) for IMACQ_PIPE
+    int pipeFd; //!< Descriptor IMACQ_PIPE reads from
+    char *rawData; //!< Mapping of an IMACQ_RAW file
+    size_t rawSize;
+    size_t *rawOffsets; //!< Offset of the (luma) plane of every frame in rawData
+    int rawNumFrames;
+    IplImage *rawFrame; //!< Header of frames viewed in place (rawData or ring)
+    FrameRing *ring; //!< Ring IMACQ_SHM reads from
+    uint64_t ringSeq; //!< Number of the ring frame handed out last
+    int decoderThreads; //!< Threads decoding IMACQ_IMGS frames ahead; 0 decodes every frame when it is needed
+    int readAhead; //!< Maximum number of frames decoded ahead
+    ImAcqDecoder *decoder;
+    IplImage *pool[IMACQ_POOL_SIZE]; //!< Recycled frame buffers, handed out by imAcqGetImg
+    int poolInUse[IMACQ_POOL_SIZE];
+    IplImage *borrowed; //!< Grey frame of the capture handed out without a copy
+    IplImage *grey; //!< Reusable greyscale buffer, see imAcqGetGrey
 } ImAcq ;
 
 ImAcq *imAcqAlloc();
@@ -71,8 +97,31 @@ IplImage *imAcqGetImgByCurrentTime(ImAcq *imAcq);
 IplImage *imAcqLoadImg(ImAcq *imAcq, char *path);
 IplImage *imAcqLoadCurrentFrame(ImAcq *imAcq);
 IplImage *imAcqLoadVidFrame(CvCapture *capture);
-IplImage *imAcqGrab(CvCapture *capture);
+IplImage *imAcqGrab(ImAcq *imAcq);
 void imAcqAdvance(ImAcq *imAcq);
+
+/**
+ * Returns a frame obtained from imAcqGetImg* to the pool and sets *img to NULL.
+ * Frames must be released with this function, never with cvReleaseImage.
+ * Grey frames of a camera or video are not copied at all; they are only valid
+ * until the next frame is grabbed.
+ */
+void imAcqReleaseImg(ImAcq *imAcq, IplImage **img);
+
+/**
+ * Returns a greyscale version of img. For grey images, this is img itself;
+ * otherwise img is converted into a buffer owned by imAcq, which is
+ * overwritten by the next call.
+ */
+IplImage *imAcqGetGrey(ImAcq *imAcq, IplImage *img);
+
+/**
+ * Whether the frame handed out last is still intact. Frames of IMACQ_SHM are
+ * viewed in place in the ring, so copies taken from them must be checked
+ * afterwards; if the producer overwrote the slot meanwhile, the frame is
+ * counted as dropped and 0 is returned. 1 for all other methods.
+ */
+int imAcqFrameIsValid(ImAcq *imAcq);
 void imAcqFree(ImAcq *);
 
 #endif /* IMACQ_H_ */
@@ -0,0 +1,219 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ImAcqDecoder.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ImAcqDecoder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+
+#include <opencv/highgui.h>
+
+enum ImAcqSlotState
+{
+    SLOT_EMPTY,
+    SLOT_DECODING,
+    SLOT_READY
+};
+
+typedef struct
+{
+    int frame;
+    int state;
+    IplImage *img;
+} ImAcqDecoderSlot;
+
+struct ImAcqDecoder
+{
+    char *pattern;
+    int lastFrame;
+    int readAhead;
+    int numThreads;
+    pthread_t *threads;
+    ImAcqDecoderSlot *slots; //slots[frame % readAhead]
+    int nextToDecode;
+    int nextToDeliver;
+    int numDecoding;
+    int stopping;
+    pthread_mutex_t mutex;
+    pthread_cond_t decoded; //A slot became ready
+    pthread_cond_t freed; //A slot became empty
+};
+
+static IplImage *imAcqDecoderLoad(ImAcqDecoder *decoder, int fNo)
+{
+    char path[255];
+    snprintf(path, sizeof(path), decoder->pattern, fNo);
+    return cvLoadImage(path);
+}
+
+static int imAcqDecoderCanClaim(ImAcqDecoder *decoder)
+{
+    return decoder->nextToDecode < decoder->nextToDeliver + decoder->readAhead
+           && (decoder->lastFrame <= 0 || decoder->nextToDecode <= decoder->lastFrame);
+}
+
+static void *imAcqDecoderRun(void *arg)
+{
+    ImAcqDecoder *decoder = (ImAcqDecoder *) arg;
+
+    pthread_mutex_lock(&decoder->mutex);
+
+    while(1)
+    {
+        while(!decoder->stopping && !imAcqDecoderCanClaim(decoder))
+        {
+            pthread_cond_wait(&decoder->freed, &decoder->mutex);
+        }
+
+        if(decoder->stopping) break;
+
+        int fNo = decoder->nextToDecode++;
+        ImAcqDecoderSlot *slot = &decoder->slots[fNo % decoder->readAhead];
+        slot->frame = fNo;
+        slot->state = SLOT_DECODING;
+        decoder->numDecoding++;
+        pthread_mutex_unlock(&decoder->mutex);
+
+        IplImage *img = imAcqDecoderLoad(decoder, fNo);
+
+        pthread_mutex_lock(&decoder->mutex);
+        slot->img = img;
+        slot->state = SLOT_READY;
+        decoder->numDecoding--;
+        pthread_cond_broadcast(&decoder->decoded);
+    }
+
+    pthread_mutex_unlock(&decoder->mutex);
+    return NULL;
+}
+
+//Waits for the frames being decoded and drops everything decoded. Called with the mutex held.
+static void imAcqDecoderDiscard(ImAcqDecoder *decoder)
+{
+    while(decoder->numDecoding > 0)
+    {
+        pthread_cond_wait(&decoder->decoded, &decoder->mutex);
+    }
+
+    for(int i = 0; i < decoder->readAhead; i++)
+    {
+        if(decoder->slots[i].img != NULL) cvReleaseImage(&decoder->slots[i].img);
+
+        decoder->slots[i].state = SLOT_EMPTY;
+    }
+}
+
+ImAcqDecoder *imAcqDecoderAlloc(const char *pattern, int firstFrame, int lastFrame, int numThreads, int readAhead)
+{
+    ImAcqDecoder *decoder = (ImAcqDecoder *) malloc(sizeof(ImAcqDecoder));
+
+    if(readAhead < numThreads) readAhead = numThreads;
+
+    decoder->pattern = strdup(pattern);
+    decoder->lastFrame = lastFrame;
+    decoder->readAhead = readAhead;
+    decoder->numThreads = numThreads;
+    decoder->slots = (ImAcqDecoderSlot *) calloc(readAhead, sizeof(ImAcqDecoderSlot));
+    decoder->nextToDecode = firstFrame;
+    decoder->nextToDeliver = firstFrame;
+    decoder->numDecoding = 0;
+    decoder->stopping = 0;
+    pthread_mutex_init(&decoder->mutex, NULL);
+    pthread_cond_init(&decoder->decoded, NULL);
+    pthread_cond_init(&decoder->freed, NULL);
+
+    decoder->threads = (pthread_t *) malloc(numThreads * sizeof(pthread_t));
+
+    for(int i = 0; i < numThreads; i++)
+    {
+        if(pthread_create(&decoder->threads[i], NULL, imAcqDecoderRun, decoder) != 0)
+        {
+            printf("Error: Unable to start decoder thread\n");
+            decoder->numThreads = i;
+            break;
+        }
+    }
+
+    return decoder;
+}
+
+IplImage *imAcqDecoderGet(ImAcqDecoder *decoder, int fNo)
+{
+    if(decoder->numThreads == 0 || (decoder->lastFrame > 0 && fNo > decoder->lastFrame))
+    {
+        return imAcqDecoderLoad(decoder, fNo); //Nobody would decode it
+    }
+
+    pthread_mutex_lock(&decoder->mutex);
+
+    if(fNo != decoder->nextToDeliver)
+    {
+        imAcqDecoderDiscard(decoder);
+        decoder->nextToDecode = fNo;
+        decoder->nextToDeliver = fNo;
+        pthread_cond_broadcast(&decoder->freed);
+    }
+
+    ImAcqDecoderSlot *slot = &decoder->slots[fNo % decoder->readAhead];
+
+    while(slot->state != SLOT_READY || slot->frame != fNo)
+    {
+        pthread_cond_wait(&decoder->decoded, &decoder->mutex);
+    }
+
+    IplImage *img = slot->img;
+    slot->img = NULL;
+    slot->state = SLOT_EMPTY;
+    decoder->nextToDeliver++;
+    pthread_cond_broadcast(&decoder->freed);
+    pthread_mutex_unlock(&decoder->mutex);
+
+    return img;
+}
+
+void imAcqDecoderFree(ImAcqDecoder *decoder)
+{
+    pthread_mutex_lock(&decoder->mutex);
+    decoder->stopping = 1;
+    pthread_cond_broadcast(&decoder->freed);
+    pthread_mutex_unlock(&decoder->mutex);
+
+    for(int i = 0; i < decoder->numThreads; i++)
+    {
+        pthread_join(decoder->threads[i], NULL);
+    }
+
+    imAcqDecoderDiscard(decoder);
+
+    pthread_mutex_destroy(&decoder->mutex);
+    pthread_cond_destroy(&decoder->decoded);
+    pthread_cond_destroy(&decoder->freed);
+    free(decoder->threads);
+    free(decoder->slots);
+    free(decoder->pattern);
+    free(decoder);
+}
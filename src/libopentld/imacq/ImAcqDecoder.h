@@ -0,0 +1,51 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ImAcqDecoder.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef IMACQDECODER_H_
+#define IMACQDECODER_H_
+
+#include <opencv/cv.h>
+
+/**
+ * Decodes the images of a sprintf pattern ahead of time with a pool of
+ * threads. Up to readAhead frames following the one delivered last are
+ * decoded in parallel, in any order, into a ring of slots; imAcqDecoderGet
+ * delivers them in order. Requesting a frame other than the next one
+ * discards what was decoded and starts over from there.
+ */
+typedef struct ImAcqDecoder ImAcqDecoder;
+
+/**
+ * lastFrame = 0 decodes until images are missing.
+ */
+ImAcqDecoder *imAcqDecoderAlloc(const char *pattern, int firstFrame, int lastFrame, int numThreads, int readAhead);
+
+/**
+ * Returns frame fNo, which the caller owns, or NULL if the image could not be loaded.
+ */
+IplImage *imAcqDecoderGet(ImAcqDecoder *decoder, int fNo);
+
+void imAcqDecoderFree(ImAcqDecoder *decoder);
+
+#endif /* IMACQDECODER_H_ */
@@ -29,6 +29,7 @@
 
 #include <cmath>
 
+#include "FrameArena.h"
 #include "Median.h"
 
 /**
@@ -53,10 +54,11 @@ float getBbHeight(float *bb)
  * to every point. Then the Median of the relative Values is used.
  */
 int predictbb(float *bb0, CvPoint2D32f *pt0, CvPoint2D32f *pt1, int nPts,
-              float *bb1, float *shift)
+              float *bb1, float *shift, tld::FrameArena *arena)
 {
-    float *ofx = (float *) malloc(sizeof(float) * nPts);
-    float *ofy = (float *) malloc(sizeof(float) * nPts);
+    tld::FrameArenaScope scope(arena);
+    float *ofx = arena->allocate<float>(nPts);
+    float *ofy = arena->allocate<float>(nPts);
     int i;
     int j;
     int d = 0;
@@ -74,14 +76,10 @@ int predictbb(float *bb0, CvPoint2D32f *pt0, CvPoint2D32f *pt1, int nPts,
 
     dx = getMedianUnmanaged(ofx, nPts);
     dy = getMedianUnmanaged(ofy, nPts);
-    free(ofx);
-    ofx = 0;
-    free(ofy);
-    ofy = 0;
     //m(m-1)/2
     lenPdist = nPts * (nPts - 1) / 2;
-    dist0 = (float *) malloc(sizeof(float) * lenPdist);
-    dist1 = (float *) malloc(sizeof(float) * lenPdist);
+    dist0 = arena->allocate<float>(lenPdist);
+    dist1 = arena->allocate<float>(lenPdist);
 
     for(i = 0; i < nPts; i++)
     {
@@ -98,10 +96,6 @@ int predictbb(float *bb0, CvPoint2D32f *pt0, CvPoint2D32f *pt1, int nPts,
     //The scale change is the median of all changes of distance.
     //same as s = median(d2./d1) with above
     *shift = getMedianUnmanaged(dist0, lenPdist);
-    free(dist0);
-    dist0 = 0;
-    free(dist1);
-    dist1 = 0;
     s0 = 0.5 * (*shift - 1) * getBbWidth(bb0);
     s1 = 0.5 * (*shift - 1) * getBbHeight(bb0);
 
@@ -30,6 +30,11 @@
 
 #include <opencv/cv.h>
 
+namespace tld
+{
+class FrameArena;
+}
+
 /**
  * @param bb0   The previous BoundingBox.
  * @param pt0   Feature points in the previous BoundingBox.
@@ -40,8 +45,9 @@
  *              1 == no scalechange, experience: if shift == 0
  *              BoundingBox moved completely out of picture
  *              (not validated)
+ * @param arena Working memory, given back on return.
  */
 int predictbb(float *bb0, CvPoint2D32f *pt0, CvPoint2D32f *pt1, int nPts,
-              float *bb1, float *shift);
+              float *bb1, float *shift, tld::FrameArena *arena);
 
 #endif /* BBPREDICT_H_ */
@@ -28,6 +28,7 @@
 
 #include <cstdio>
 
+#include "FrameArena.h"
 #include "BB.h"
 #include "BBPredict.h"
 #include "Median.h"
@@ -41,10 +42,12 @@
  * @param bb         Bounding box of object to track in imgI.
  *                   Format x1,y1,x2,y2
  * @param scaleshift returns relative scale change of bb
+ * @param arena      working memory, given back on return
  */
 int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
-            float *scaleshift)
+            float *scaleshift, tld::FrameArena *arena)
 {
+    tld::FrameArenaScope scope(arena);
     char level = 5;
     const int numM = 10;
     const int numN = 10;
@@ -62,6 +65,7 @@ int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
     CvPoint2D32f *targetPoints;
     float *fbLkCleaned;
     float *nccLkCleaned;
+    float *sorted;
     int i, M;
     int nRealPoints;
     float medFb;
@@ -71,9 +75,7 @@ int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
     //getFilledBBPoints(bb, numM, numN, 5, &ptTracked);
     memcpy(ptTracked, pt, sizeof(float) * sizePointsArray);
 
-    initImgs();
-    trackLK(imgI, imgJ, pt, nPoints, ptTracked, nPoints, level, fb, ncc, status);
-    initImgs();
+    trackLK(imgI, imgJ, pt, nPoints, ptTracked, nPoints, level, fb, ncc, status, arena);
     //  char* status = *statusP;
     nlkPoints = 0;
 
@@ -82,10 +84,11 @@ int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
         nlkPoints += status[i];
     }
 
-    startPoints = (CvPoint2D32f *) malloc(nlkPoints * sizeof(CvPoint2D32f));
-    targetPoints = (CvPoint2D32f *) malloc(nlkPoints * sizeof(CvPoint2D32f));
-    fbLkCleaned = (float *) malloc(nlkPoints * sizeof(float));
-    nccLkCleaned = (float *) malloc(nlkPoints * sizeof(float));
+    startPoints = arena->allocate<CvPoint2D32f>(nlkPoints);
+    targetPoints = arena->allocate<CvPoint2D32f>(nlkPoints);
+    fbLkCleaned = arena->allocate<float>(nlkPoints);
+    nccLkCleaned = arena->allocate<float>(nlkPoints);
+    sorted = arena->allocate<float>(nlkPoints);
 
     M = 2;
     nRealPoints = 0;
@@ -110,8 +113,11 @@ int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
     }
 
     //assert nRealPoints==nlkPoints
-    medFb = getMedian(fbLkCleaned, nlkPoints);
-    medNcc = getMedian(nccLkCleaned, nlkPoints);
+    //Same as getMedian, with the copy taken from the arena
+    memcpy(sorted, fbLkCleaned, sizeof(float) * nlkPoints);
+    medFb = getMedianUnmanaged(sorted, nlkPoints);
+    memcpy(sorted, nccLkCleaned, sizeof(float) * nlkPoints);
+    medNcc = getMedianUnmanaged(sorted, nlkPoints);
     /*  printf("medianfb: %f\nmedianncc: %f\n", medFb, medNcc);
      printf("Number of points after lk: %d\n", nlkPoints);*/
     nAfterFbUsage = 0;
@@ -133,16 +139,12 @@ int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew,
     //      nRealPoints);
     //  showIplImage(imgI);
 
-    predictbb(bb, startPoints, targetPoints, nAfterFbUsage, bbnew, scaleshift);
+    predictbb(bb, startPoints, targetPoints, nAfterFbUsage, bbnew, scaleshift, arena);
     /*printf("bbnew: %f,%f,%f,%f\n", bbnew[0], bbnew[1], bbnew[2], bbnew[3]);
      printf("relative scale: %f \n", scaleshift[0]);*/
     //show picture with tracked bb
     //  drawRectFromBB(imgJ, bbnew);
     //  showIplImage(imgJ);
-    free(startPoints);
-    free(targetPoints);
-    free(fbLkCleaned);
-    free(nccLkCleaned);
 
     if(medFb > 10) return 0;
     else return 1;
@@ -29,13 +29,19 @@
 
 #include <opencv/cv.h>
 
+namespace tld
+{
+class FrameArena;
+}
+
 /*
  * @param imgI       Image contain Object with known BoundingBox
  * @param imgJ       Following Image.
  * @param bb         Bounding box of object to track in imgI.
  *                   Format x1,y1,x2,y2
  * @param scaleshift returns relative scale change of bb
+ * @param arena      working memory, given back on return
  */
-int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew, float *scaleshift);
+int fbtrack(IplImage *imgI, IplImage *imgJ, float *bb, float *bbnew, float *scaleshift, tld::FrameArena *arena);
 
 #endif /* FBTRACK_H_ */
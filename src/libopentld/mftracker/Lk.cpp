@@ -32,6 +32,8 @@
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
 
+#include "FrameArena.h"
+
 const int MAX_COUNT = 500;
 const int MAX_IMG = 2;
 const double N_A_N = -1.0;
@@ -40,7 +42,7 @@ const double N_A_N = -1.0;
  */
 int win_size_lk = 4;
 CvPoint2D32f *points[3] = { 0, 0, 0 };
-static IplImage **PYR = 0;
+static IplImage *PYR[MAX_IMG] = { 0, 0 };
 
 /**
  * Calculates euclidean distance between the point pairs.
@@ -78,14 +80,21 @@ void euclideanDistance(CvPoint2D32f *point1, CvPoint2D32f *point2,
  *                  which is compared.
  * @param method    Specifies the way how image regions are compared.
  *                  see cvMatchTemplate
+ * @param arena     Holds the pixels of the compared regions.
  */
 void normCrossCorrelation(IplImage *imgI, IplImage *imgJ,
                           CvPoint2D32f *points0, CvPoint2D32f *points1, int nPts, char *status,
-                          float *match, int winsize, int method)
+                          float *match, int winsize, int method, tld::FrameArena *arena)
 {
-    IplImage *rec0 = cvCreateImage(cvSize(winsize, winsize), 8, 1);
-    IplImage *rec1 = cvCreateImage(cvSize(winsize, winsize), 8, 1);
-    IplImage *res = cvCreateImage(cvSize(1, 1), IPL_DEPTH_32F, 1);
+    IplImage rec0Header;
+    IplImage rec1Header;
+    IplImage resHeader;
+    IplImage *rec0 = cvInitImageHeader(&rec0Header, cvSize(winsize, winsize), 8, 1);
+    IplImage *rec1 = cvInitImageHeader(&rec1Header, cvSize(winsize, winsize), 8, 1);
+    IplImage *res = cvInitImageHeader(&resHeader, cvSize(1, 1), IPL_DEPTH_32F, 1);
+    rec0->imageData = arena->allocate<char>(rec0->imageSize);
+    rec1->imageData = arena->allocate<char>(rec1->imageSize);
+    res->imageData = arena->allocate<char>(res->imageSize);
 
     int i;
 
@@ -103,40 +112,31 @@ void normCrossCorrelation(IplImage *imgI, IplImage *imgJ,
             match[i] = 0.0;
         }
     }
-
-    cvReleaseImage(&rec0);
-    cvReleaseImage(&rec1);
-    cvReleaseImage(&res);
 }
 
 /**
- * Needed before start of trackLK and at the end of the program for cleanup.
+ * Releases the pyramids that trackLK keeps between calls. Needed at the end
+ * of the program for cleanup.
  * Handles PYR(Pyramid cache) variable.
  */
 void initImgs()
 {
-    if(PYR != 0)
-    {
-        int i;
+    int i;
 
-        for(i = 0; i < MAX_IMG; i++)
+    for(i = 0; i < MAX_IMG; i++)
+    {
+        if(PYR[i] != 0)
         {
             cvReleaseImage(&(PYR[i]));
             PYR[i] = 0;
         }
-
-        free(PYR);
-        PYR = 0;
-        //printf("LK: deallocated\n");
     }
-
-    PYR = (IplImage **) calloc(MAX_IMG, sizeof(IplImage *));
-    //printf("LK: initialized\n");
 }
 
 /**
  * Tracks Points from 1.Image to 2.Image.
- * Need initImgs before start and at the end of the program for cleanup.
+ * The pyramids are kept for the next call as long as the image size stays
+ * the same; initImgs releases them.
  *
  * @param imgI      previous Image source. (isn't changed)
  * @param imgJ      actual Image target. (isn't changed)
@@ -153,6 +153,7 @@ void initImgs()
  * @param ncc       normCrossCorrelation values. needs as inputlength nPtsI * sizeof(float)
  * @param status    Indicates positive tracks. 1 = PosTrack 0 = NegTrack
  *                  needs as inputlength nPtsI * sizeof(char)
+ * @param arena     working memory, given back on return
  *
  *
  * Based Matlab function:
@@ -160,8 +161,10 @@ void initImgs()
  */
 
 int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
-            float ptsJ[], int nPtsJ, int level, float *fb, float *ncc, char *status)
+            float ptsJ[], int nPtsJ, int level, float *fb, float *ncc, char *status, tld::FrameArena *arena)
 {
+    tld::FrameArenaScope scope(arena);
+
     //TODO: watch NaN cases
     //double nan = std::numeric_limits<double>::quiet_NaN();
     //double inf = std::numeric_limits<double>::infinity();
@@ -181,10 +184,23 @@ int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
     J = 1;
     winsize_ncc = 10;
 
-    //NOTE: initImgs() must be used correctly or memleak will follow.
+    //Both pyramids are rebuilt by the first cvCalcOpticalFlowPyrLK below,
+    //so buffers of the last call can be used if they have the right size
     pyr_sz = cvSize(imgI->width + 8, imgI->height / 3);
-    PYR[I] = cvCreateImage(pyr_sz, IPL_DEPTH_32F, 1);
-    PYR[J] = cvCreateImage(pyr_sz, IPL_DEPTH_32F, 1);
+
+    for(i = 0; i < MAX_IMG; i++)
+    {
+        if(PYR[i] != 0 && (PYR[i]->width != pyr_sz.width || PYR[i]->height != pyr_sz.height))
+        {
+            cvReleaseImage(&(PYR[i]));
+            PYR[i] = 0;
+        }
+
+        if(PYR[i] == 0)
+        {
+            PYR[i] = cvCreateImage(pyr_sz, IPL_DEPTH_32F, 1);
+        }
+    }
 
     // Points
     if(nPtsJ != nPtsI)
@@ -193,11 +209,10 @@ int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
         return 0;
     }
 
-    points[0] = (CvPoint2D32f *) malloc(nPtsI * sizeof(CvPoint2D32f)); // template
-    points[1] = (CvPoint2D32f *) malloc(nPtsI * sizeof(CvPoint2D32f)); // target
-    points[2] = (CvPoint2D32f *) malloc(nPtsI * sizeof(CvPoint2D32f)); // forward-backward
-    //TODO:Free
-    char *statusBacktrack = (char *) malloc(nPtsI);
+    points[0] = arena->allocate<CvPoint2D32f>(nPtsI); // template
+    points[1] = arena->allocate<CvPoint2D32f>(nPtsI); // target
+    points[2] = arena->allocate<CvPoint2D32f>(nPtsI); // forward-backward
+    char *statusBacktrack = arena->allocate<char>(nPtsI);
 
     for(i = 0; i < nPtsI; i++)
     {
@@ -234,7 +249,7 @@ int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
     }
 
     normCrossCorrelation(imgI, imgJ, points[0], points[1], nPtsI, status, ncc,
-                         winsize_ncc, CV_TM_CCOEFF_NORMED);
+                         winsize_ncc, CV_TM_CCOEFF_NORMED, arena);
     euclideanDistance(points[0], points[2], fb, nPtsI);
 
     for(i = 0; i < nPtsI; i++)
@@ -256,10 +271,8 @@ int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
 
     for(i = 0; i < 3; i++)
     {
-        free(points[i]);
         points[i] = 0;
     }
 
-    free(statusBacktrack);
     return 1;
 }
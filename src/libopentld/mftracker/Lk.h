@@ -29,12 +29,18 @@
 
 #include <opencv/cv.h>
 
+namespace tld
+{
+class FrameArena;
+}
+
 /**
- * Need before start of trackLK and at the end of the program for cleanup.
+ * Releases the pyramids that trackLK keeps between calls. Needed at the end
+ * of the program for cleanup.
  */
 void initImgs();
 int trackLK(IplImage *imgI, IplImage *imgJ, float ptsI[], int nPtsI,
             float ptsJ[], int nPtsJ, int level, float *fbOut, float *nccOut,
-            char *statusOut);
+            char *statusOut, tld::FrameArena *arena);
 
 #endif /* LK_H_ */
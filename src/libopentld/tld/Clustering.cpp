@@ -37,8 +37,8 @@ namespace tld
 Clustering::Clustering()
 {
     cutoff = .5;
-    windows = NULL;
-    numWindows = 0;
+    windowGrid = NULL;
+    frameArena = NULL;
 }
 
 Clustering::~Clustering()
@@ -47,8 +47,7 @@ Clustering::~Clustering()
 
 void Clustering::release()
 {
-    windows = NULL;
-    numWindows = 0;
+    windowGrid = NULL;
 }
 
 void Clustering::calcMeanRect(vector<int> * indices)
@@ -61,7 +60,8 @@ void Clustering::calcMeanRect(vector<int> * indices)
 
     for(int i = 0; i < numIndices; i++)
     {
-        int *bb = &windows[TLD_WINDOW_SIZE * indices->at(i)];
+        int bb[TLD_WINDOW_SIZE];
+        windowGrid->window(indices->at(i), bb);
         x += bb[0];
         y += bb[1];
         w += bb[2];
@@ -73,7 +73,7 @@ void Clustering::calcMeanRect(vector<int> * indices)
     w /= numIndices;
     h /= numIndices;
 
-    Rect *rect = new Rect();
+    Rect *rect = &detectionResult->detectorRect;
     detectionResult->detectorBB = rect;
     rect->x = floor(x + 0.5);
     rect->y = floor(y + 0.5);
@@ -87,15 +87,14 @@ void Clustering::calcDistances(float *distances)
 {
     float *distances_tmp = distances;
 
-    vector<int> confidentIndices = *detectionResult->confidentIndices;
+    const vector<int> &confidentIndices = *detectionResult->confidentIndices;
 
     size_t indices_size = confidentIndices.size();
 
-    for(size_t i = 0; i < confidentIndices.size(); i++)
+    //Row i holds the distances of window i to all windows after it
+    for(size_t i = 0; i + 1 < indices_size; i++)
     {
-        int firstIndex = confidentIndices.at(0);
-        confidentIndices.erase(confidentIndices.begin());
-        tldOverlapOne(windows, numWindows, firstIndex, &confidentIndices, distances_tmp);
+        tldOverlapOne(windowGrid, confidentIndices[i], &confidentIndices[i + 1], indices_size - i - 1, distances_tmp);
         distances_tmp += indices_size - i - 1;
     }
 
@@ -108,10 +107,12 @@ void Clustering::calcDistances(float *distances)
 
 void Clustering::clusterConfidentIndices()
 {
+    FrameArenaScope scope(frameArena);
+
     int numConfidentIndices = detectionResult->confidentIndices->size();
-    float *distances = new float[numConfidentIndices * (numConfidentIndices - 1) / 2];
+    float *distances = frameArena->allocate<float>(numConfidentIndices * (numConfidentIndices - 1) / 2);
     calcDistances(distances);
-    int *clusterIndices = new int[numConfidentIndices];
+    int *clusterIndices = frameArena->allocate<int>(numConfidentIndices);
     cluster(distances, clusterIndices);
 
     if(detectionResult->numClusters == 1)
@@ -120,7 +121,6 @@ void Clustering::clusterConfidentIndices()
         //TODO: Take the maximum confidence as the result confidence.
     }
 
-
 }
 
 void Clustering::cluster(float *distances, int *clusterIndices)
@@ -137,7 +137,7 @@ void Clustering::cluster(float *distances, int *clusterIndices)
     int numDistances = numConfidentIndices * (numConfidentIndices - 1) / 2;
 
     //Now: Cluster distances
-    int *distUsed = new int[numDistances];
+    int *distUsed = frameArena->allocate<int>(numDistances);
 
     for(int i = 0; i < numDistances; i++)
     {
@@ -31,6 +31,8 @@
 #include <opencv/cv.h>
 
 #include "DetectionResult.h"
+#include "FrameArena.h"
+#include "WindowGrid.h"
 
 namespace tld
 {
@@ -41,8 +43,8 @@ class Clustering
     void calcDistances(float *distances);
     void cluster(float *distances, int *clusterIndices);
 public:
-    int *windows;
-    int numWindows;
+    const WindowGrid *windowGrid;
+    FrameArena *frameArena; //Working memory of clusterConfidentIndices
 
     DetectionResult *detectionResult;
 
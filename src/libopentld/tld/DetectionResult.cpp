@@ -26,6 +26,8 @@
 
 #include "DetectionResult.h"
 
+#include <cstring>
+
 #include "TLDUtil.h"
 
 using namespace cv;
@@ -39,12 +41,18 @@ DetectionResult::DetectionResult()
     containsValidData = false;
     fgList = new vector<Rect>();
     confidentIndices = new vector<int>();
+    varianceIndices = new vector<int>();
+    ensembleIndices = new vector<int>();
     numClusters = 0;
     detectorBB = NULL;
 
     variances = NULL;
     posteriors = NULL;
     featureVectors = NULL;
+    windowFlags = NULL;
+    windowStages = NULL;
+
+    hugePages = HUGE_PAGES_OFF;
 }
 
 DetectionResult::~DetectionResult()
@@ -54,10 +62,23 @@ DetectionResult::~DetectionResult()
 
 void DetectionResult::init(int numWindows, int numTrees)
 {
-    variances = new float[numWindows];
-    posteriors = new float[numWindows];
-    featureVectors = new int[numWindows * numTrees];
-    confidentIndices = new vector<int>();
+    variances = tldAllocLargeArray<float>(numWindows, hugePages);
+    posteriors = tldAllocLargeArray<float>(numWindows, hugePages);
+    featureVectors = tldAllocLargeArray<int>(numWindows * numTrees, hugePages);
+    windowFlags = tldAllocLargeArray<char>(numWindows, hugePages);
+    windowStages = tldAllocLargeArray<char>(numWindows, hugePages);
+    memset(windowStages, WINDOW_UNKNOWN, numWindows);
+
+    if(confidentIndices == NULL) confidentIndices = new vector<int>();
+
+    if(varianceIndices == NULL) varianceIndices = new vector<int>();
+
+    if(ensembleIndices == NULL) ensembleIndices = new vector<int>();
+
+    //The stages never reallocate while detecting
+    confidentIndices->reserve(numWindows);
+    varianceIndices->reserve(numWindows);
+    ensembleIndices->reserve(numWindows);
 
 }
 
@@ -69,23 +90,33 @@ void DetectionResult::reset()
 
     if(confidentIndices != NULL) confidentIndices->clear();
 
+    if(varianceIndices != NULL) varianceIndices->clear();
+
+    if(ensembleIndices != NULL) ensembleIndices->clear();
+
     numClusters = 0;
-    delete detectorBB;
     detectorBB = NULL;
 }
 
 void DetectionResult::release()
 {
     fgList->clear();
-    delete[] variances;
+    tldFreeLarge(variances);
     variances = NULL;
-    delete[] posteriors;
+    tldFreeLarge(posteriors);
     posteriors = NULL;
-    delete[] featureVectors;
+    tldFreeLarge(featureVectors);
     featureVectors = NULL;
+    tldFreeLarge(windowFlags);
+    windowFlags = NULL;
+    tldFreeLarge(windowStages);
+    windowStages = NULL;
     delete confidentIndices;
     confidentIndices = NULL;
-    delete detectorBB;
+    delete varianceIndices;
+    varianceIndices = NULL;
+    delete ensembleIndices;
+    ensembleIndices = NULL;
     detectorBB = NULL;
     containsValidData = false;
 }
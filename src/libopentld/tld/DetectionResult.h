@@ -31,9 +31,21 @@
 
 #include <opencv/cv.h>
 
+#include "LargeAlloc.h"
+
 namespace tld
 {
 
+//The outcome of the cascade for a window, for reusing it in the next frame
+enum WindowStage
+{
+    WINDOW_UNKNOWN, //Not evaluated or evaluated without saving the outcome
+    WINDOW_VARIANCE_REJECTED,
+    WINDOW_ENSEMBLE_REJECTED,
+    WINDOW_NN_REJECTED,
+    WINDOW_CONFIDENT
+};
+
 class DetectionResult
 {
 public:
@@ -41,10 +53,16 @@ public:
     std::vector<cv::Rect>* fgList;
     float *posteriors;  /* Contains the posteriors for each slding window. Is of size numWindows. Allocated by tldInitClassifier. */
     std::vector<int>* confidentIndices;
+    std::vector<int>* varianceIndices; //Windows that passed the variance filter, in ascending order
+    std::vector<int>* ensembleIndices; //Windows that passed the ensemble classifier, in ascending order
+    char *windowFlags; //Working memory of the cascade stages, numWindows entries
+    char *windowStages; //How far each window got in the cascade, see WindowStage. Kept for the next frame.
     int *featureVectors;
     float *variances;
     int numClusters;
     cv::Rect *detectorBB; //Contains a valid result only if numClusters = 1
+    cv::Rect detectorRect; //Storage of detectorBB
+    int hugePages; //HugePageMode of the per-window arrays, set before init
 
     DetectionResult();
     virtual ~DetectionResult();
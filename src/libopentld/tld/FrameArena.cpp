@@ -0,0 +1,129 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * FrameArena.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "FrameArena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace tld
+{
+
+//Size of the first block
+static const size_t minBlockSize = 64 * 1024;
+
+FrameArena::FrameArena()
+{
+    block = 0;
+    offset = 0;
+    numHeapAllocations = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    for(size_t i = 0; i < blocks.size(); i++)
+    {
+        free(blocks[i].data);
+    }
+}
+
+//Inserts a block after the current one
+void FrameArena::addBlock(size_t size)
+{
+    Block b;
+    b.data = (char *) malloc(size);
+    b.size = size;
+
+    if(b.data == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    numHeapAllocations++;
+
+    size_t position = blocks.empty() ? 0 : block + 1;
+    blocks.insert(blocks.begin() + position, b);
+    block = position;
+    offset = 0;
+}
+
+void *FrameArena::allocate(size_t size)
+{
+    size = (size + 15) & ~(size_t) 15;
+
+    if(blocks.empty() || offset + size > blocks[block].size)
+    {
+        if(!blocks.empty() && block + 1 < blocks.size() && size <= blocks[block + 1].size)
+        {
+            block++;
+            offset = 0;
+        }
+        else
+        {
+            //Grow geometrically, so that a frame needs few blocks
+            size_t blockSize = blocks.empty() ? minBlockSize : 2 * blocks[block].size;
+            addBlock((size > blockSize) ? size : blockSize);
+        }
+    }
+
+    void *p = blocks[block].data + offset;
+    offset += size;
+    return p;
+}
+
+void FrameArena::reset()
+{
+    if(blocks.size() > 1)
+    {
+        size_t total = 0;
+
+        for(size_t i = 0; i < blocks.size(); i++)
+        {
+            total += blocks[i].size;
+            free(blocks[i].data);
+        }
+
+        blocks.clear();
+        addBlock(total);
+    }
+
+    block = 0;
+    offset = 0;
+}
+
+FrameArena::Mark FrameArena::mark() const
+{
+    Mark m;
+    m.block = block;
+    m.offset = offset;
+    return m;
+}
+
+void FrameArena::rewind(const Mark &mark)
+{
+    block = mark.block;
+    offset = mark.offset;
+}
+
+} /* namespace tld */
@@ -0,0 +1,102 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * FrameArena.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef FRAMEARENA_H_
+#define FRAMEARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+namespace tld
+{
+
+/**
+ * Bump allocator for the temporaries of one frame. Memory is handed out from
+ * large blocks and never freed individually; reset() makes all of it
+ * available again at once. If a frame needed more than one block, reset()
+ * replaces them by a single block of their total size, so once the arena has
+ * seen the largest frame it does not touch the heap any more.
+ * Not thread-safe: allocate before entering a parallel region.
+ */
+class FrameArena
+{
+    struct Block
+    {
+        char *data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t block; //Block that is allocated from
+    size_t offset; //Bytes used in it
+
+    void addBlock(size_t size);
+
+public:
+    struct Mark
+    {
+        size_t block;
+        size_t offset;
+    };
+
+    uint64_t numHeapAllocations; //Blocks taken from the heap so far
+
+    FrameArena();
+    virtual ~FrameArena();
+
+    void *allocate(size_t size); //16 byte aligned
+    void reset();
+
+    //Allocations after mark() are given back by rewind(mark)
+    Mark mark() const;
+    void rewind(const Mark &mark);
+
+    template<class T>
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(allocate(count * sizeof(T)));
+    }
+};
+
+//Gives back everything allocated from the arena during its lifetime
+class FrameArenaScope
+{
+    FrameArena *arena;
+    FrameArena::Mark begin;
+
+public:
+    FrameArenaScope(FrameArena *arena) : arena(arena), begin(arena->mark())
+    {
+    }
+
+    ~FrameArenaScope()
+    {
+        arena->rewind(begin);
+    }
+};
+
+} /* namespace tld */
+#endif /* FRAMEARENA_H_ */
@@ -27,20 +27,19 @@
 #define IDETECTORCASCADE_H_
 
 #include "DetectionResult.h"
-//#include "ForegroundDetector.h"
+#include "ForegroundDetector.h"
 #include "IVarianceFilter.h"
 #include "IEnsembleClassifier.h"
 #include "INNClassifier.h"
 #include "Clustering.h"
+#include "FrameArena.h"
+#include "Metrics.h"
+#include "WindowGrid.h"
 
 
 namespace tld
 {
 
-//Constants
-static const int TLD_WINDOW_SIZE = 5;
-static const int TLD_WINDOW_OFFSET_SIZE = 6;
-
 //TODO: Convert this to a function
 #define sub2idx(x,y,imgWidthStep) ((int) (floor((x)+0.5) + floor((y)+0.5)*(imgWidthStep)))
 
@@ -59,6 +58,10 @@ public:
     int minSize;
     int numFeatures;
     int numTrees;
+    bool reuseUnchanged; //Reuse the outcome of windows whose pixels did not change since the last detection
+    int changeThreshold; //Largest pixel difference that counts as unchanged
+    int coarseStep; //Scan every coarseStep-th window first and refine around its hits; 1 scans all windows
+    int hugePages; //HugePageMode of the per-window arrays and the integral images
 
     //Needed for init
     int imgWidth;
@@ -68,8 +71,7 @@ public:
     int objHeight;								
 
     int numWindows;
-    int *windows;
-    int *windowOffsets;
+    WindowGrid windowGrid; //Position and integral image offsets of every window
 
     //State data
     bool initialised;
@@ -77,20 +79,24 @@ public:
     DetectionResult *detectionResult;
 
     //Components of Detector Cascade
-    //ForegroundDetector *foregroundDetector;
+    ForegroundDetector *foregroundDetector;
     IVarianceFilter *varianceFilter;
     IEnsembleClassifier *ensembleClassifier;
     Clustering *clustering;
     INNClassifier *nnClassifier;
 
+    Metrics *metrics; //Stage timings and funnel counts, if set. Not owned.
+    FrameArena *frameArena; //Temporaries of the current frame, must be set before init. Not owned.
+
     virtual void init() = 0;
-    virtual void initWindowOffsets() = 0;
     virtual void initWindowsAndScales() = 0;
     virtual void propagateMembers() = 0;
     virtual void release() = 0;						
     virtual void cleanPreviousData() = 0;			
     virtual void detect(const cv::Mat &img) = 0;	
     virtual void setImgSize(int w, int h, int step) { imgWidth = w; imgHeight = h; imgWidthStep = step; }
+    virtual void invalidateResults() {} //Must be called when the model changes
+    virtual void updateFeatureVectors(const std::vector<int> &windowIndices) {} //Computes the features of the given windows that the last detection skipped
 };
 
 } /* namespace tld */
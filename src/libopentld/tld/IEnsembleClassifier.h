@@ -26,8 +26,13 @@
 #ifndef IENSEMBLECLASSIFIER_H_
 #define IENSEMBLECLASSIFIER_H_
 
+#include <vector>
+
 #include <opencv/cv.h>
 
+#include "DetectionResult.h"
+#include "WindowGrid.h"
+
 namespace tld
 {
 
@@ -44,7 +49,7 @@ public:
     int numScales;
     cv::Size *scales;
 
-    int *windowOffsets;
+    const WindowGrid *windowGrid;
     int *featureOffsets;
     float *features;
 
@@ -54,6 +59,18 @@ public:
     int *positives;
     int *negatives;
 
+    //Set if features and the posterior tables point into a shared model
+    //(see ModelFile). They are not owned and must not be deleted.
+    bool sharedModel;
+
+    //If set, the index of every leaf touched by updatePosterior is appended
+    //(see ModelJournal)
+    std::vector<int> *changedLeaves;
+
+    //Counts the calls of updatePosterior, so that callers can tell whether
+    //learning changed the posteriors
+    unsigned int numUpdates;
+
     DetectionResult *detectionResult;
 
     virtual void init() = 0;
@@ -63,6 +80,15 @@ public:
     virtual void release() = 0;
     virtual void updatePosterior(int treeIdx, int idx, int positive, int amount) = 0;
     virtual void learn(int *boundary, int positive, int *featureVector) = 0;
+
+    //Learns the given windows of the last detection in order
+    virtual void learn(const std::vector<int> &windowIndices, int positive)
+    {
+        for(size_t i = 0; i < windowIndices.size(); i++)
+        {
+            learn(NULL, positive, detectionResult->featureVectors + numTrees * windowIndices[i]);
+        }
+    }
 };
 
 } /* namespace tld */
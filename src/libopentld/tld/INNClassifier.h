@@ -32,6 +32,7 @@
 
 #include "NormalizedPatch.h"
 #include "DetectionResult.h"
+#include "WindowGrid.h"
 
 namespace tld
 {
@@ -41,16 +42,47 @@ class INNClassifier
 public:
     bool enabled;
 
-    int *windows;
+    const WindowGrid *windowGrid;
     float thetaFP;
     float thetaTP;
     DetectionResult *detectionResult;
     std::vector<NormalizedPatch>* falsePositives;
     std::vector<NormalizedPatch>* truePositives;
 
+    //Templates of a shared model (see ModelFile). They precede the ones in
+    //truePositives/falsePositives, which only hold what was learned since.
+    const float *sharedFalsePositives;
+    const float *sharedTruePositives;
+    int numSharedFalsePositives;
+    int numSharedTruePositives;
+
+    int numFalsePositives() const
+    {
+        return numSharedFalsePositives + falsePositives->size();
+    }
+
+    int numTruePositives() const
+    {
+        return numSharedTruePositives + truePositives->size();
+    }
+
+    const float *falsePositive(int i) const
+    {
+        if(i < numSharedFalsePositives) return sharedFalsePositives + i * TLD_PATCH_SIZE * TLD_PATCH_SIZE;
+
+        return falsePositives->at(i - numSharedFalsePositives).values;
+    }
+
+    const float *truePositive(int i) const
+    {
+        if(i < numSharedTruePositives) return sharedTruePositives + i * TLD_PATCH_SIZE * TLD_PATCH_SIZE;
+
+        return truePositives->at(i - numSharedTruePositives).values;
+    }
+
     virtual void release() = 0;
     virtual float classifyBB(const cv::Mat &img, cv::Rect *bb) = 0;
-    virtual void learn(std::vector<NormalizedPatch> patches) = 0;
+    virtual void learn(const std::vector<NormalizedPatch> &patches) = 0;
 };
 
 } /* namespace tld */
@@ -30,6 +30,7 @@
 
 #include "IntegralImage.h"
 #include "DetectionResult.h"
+#include "WindowGrid.h"
 
 namespace tld
 {
@@ -38,11 +39,12 @@ class IVarianceFilter
 {
 public:
     bool enabled;
-    int *windowOffsets;
+    const WindowGrid *windowGrid;
 
     DetectionResult *detectionResult;
 
     float minVar;
+    int hugePages; //HugePageMode of the integral images
 
     virtual ~IVarianceFilter() { }
 
@@ -0,0 +1,191 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * LargeAlloc.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "LargeAlloc.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace tld
+{
+
+#define TLD_CACHE_LINE_SIZE 64
+#define TLD_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+//Precedes every buffer, padded to a cache line
+struct LargeHeader
+{
+    void *base;
+    size_t mappedSize; //0 if base came from the heap
+};
+
+static const char *hugePageModeNames[] = {"OFF", "TRANSPARENT", "EXPLICIT"};
+
+static bool hugePagesWarned = false;
+
+static void *allocAligned(size_t alignment, size_t size)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void *p;
+    return (posix_memalign(&p, alignment, size) == 0) ? p : NULL;
+#endif
+}
+
+static void freeAligned(void *p)
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void *tldAllocLarge(size_t size, int hugePages)
+{
+    size_t total = size + TLD_CACHE_LINE_SIZE;
+    void *base = NULL;
+    size_t mappedSize = 0;
+
+#ifdef __linux__
+
+    if(hugePages != HUGE_PAGES_OFF && total >= TLD_HUGE_PAGE_SIZE / 2)
+    {
+        size_t rounded = (total + TLD_HUGE_PAGE_SIZE - 1) & ~(size_t)(TLD_HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+
+        if(hugePages == HUGE_PAGES_EXPLICIT)
+        {
+            void *p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if(p != MAP_FAILED)
+            {
+                base = p;
+                mappedSize = rounded;
+            }
+            else if(!hugePagesWarned)
+            {
+                hugePagesWarned = true;
+                printf("Warning: No huge pages reserved (see /proc/sys/vm/nr_hugepages), using transparent huge pages\n");
+            }
+        }
+
+#endif
+
+        if(base == NULL)
+        {
+            base = allocAligned(TLD_HUGE_PAGE_SIZE, rounded);
+
+#ifdef MADV_HUGEPAGE
+
+            if(base != NULL)
+            {
+                madvise(base, rounded, MADV_HUGEPAGE);
+            }
+
+#endif
+        }
+    }
+
+#endif
+
+    if(base == NULL)
+    {
+        base = allocAligned(TLD_CACHE_LINE_SIZE, total);
+    }
+
+    if(base == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    LargeHeader *header = (LargeHeader *) base;
+    header->base = base;
+    header->mappedSize = mappedSize;
+
+    return (char *) base + TLD_CACHE_LINE_SIZE;
+}
+
+void tldFreeLarge(void *p)
+{
+    if(p == NULL)
+    {
+        return;
+    }
+
+    LargeHeader *header = (LargeHeader *)((char *) p - TLD_CACHE_LINE_SIZE);
+
+#ifdef __linux__
+
+    if(header->mappedSize > 0)
+    {
+        munmap(header->base, header->mappedSize);
+        return;
+    }
+
+#endif
+
+    freeAligned(header->base);
+}
+
+int tldHugePageMode(const char *name)
+{
+    for(int mode = 0; mode < 3; mode++)
+    {
+        const char *a = name;
+        const char *b = hugePageModeNames[mode];
+
+        while(*a != '\0' && toupper((unsigned char) *a) == *b)
+        {
+            a++;
+            b++;
+        }
+
+        if(*a == '\0' && *b == '\0')
+        {
+            return mode;
+        }
+    }
+
+    return -1;
+}
+
+const char *tldHugePageModeName(int mode)
+{
+    return hugePageModeNames[mode];
+}
+
+} /* namespace tld */
@@ -0,0 +1,60 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * LargeAlloc.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef LARGEALLOC_H_
+#define LARGEALLOC_H_
+
+#include <cstddef>
+
+namespace tld
+{
+
+enum HugePageMode
+{
+    HUGE_PAGES_OFF, //Cache line aligned heap memory
+    HUGE_PAGES_TRANSPARENT, //Large buffers are aligned to 2 MB and the kernel is asked to back them with huge pages
+    HUGE_PAGES_EXPLICIT //Large buffers are mapped from the reserved huge pages, transparent ones if none are left
+};
+
+/*
+ * Memory for arrays with an entry per window or per pixel, which are large
+ * enough for their accesses to miss the TLB. The memory is 64 byte aligned.
+ * Buffers of at least half a huge page are backed by 2 MB pages where the
+ * mode and the system allow it (Linux only); otherwise they come from the
+ * heap. The contents are not initialized.
+ */
+void *tldAllocLarge(size_t size, int hugePages);
+void tldFreeLarge(void *p); //p may be NULL
+
+int tldHugePageMode(const char *name); //OFF, TRANSPARENT or EXPLICIT, in any case; -1 if unknown
+const char *tldHugePageModeName(int mode);
+
+template<class T>
+T *tldAllocLargeArray(size_t count, int hugePages)
+{
+    return static_cast<T *>(tldAllocLarge(count * sizeof(T), hugePages));
+}
+
+} /* namespace tld */
+#endif /* LARGEALLOC_H_ */
@@ -29,6 +29,7 @@
 #include <cmath>
 
 #include "FBTrack.h"
+#include "Lk.h"
 
 using namespace cv;
 
@@ -38,16 +39,17 @@ namespace tld
 MedianFlowTracker::MedianFlowTracker()
 {
     trackerBB = NULL;
+    frameArena = NULL;
 }
 
 MedianFlowTracker::~MedianFlowTracker()
 {
     cleanPreviousData();
+    initImgs(); //Releases the pyramids kept by trackLK
 }
 
 void MedianFlowTracker::cleanPreviousData()
 {
-    delete trackerBB;
     trackerBB = NULL;
 }
 
@@ -66,7 +68,7 @@ void MedianFlowTracker::track(const Mat &prevMat, const Mat &currMat, Rect *prev
         IplImage prevImg = prevMat;
         IplImage currImg = currMat;
 
-        int success = fbtrack(&prevImg, &currImg, bb_tracker, bb_tracker, &scale);
+        int success = fbtrack(&prevImg, &currImg, bb_tracker, bb_tracker, &scale, frameArena);
 
         //Extract subimage
         float x, y, w, h;
@@ -82,7 +84,8 @@ void MedianFlowTracker::track(const Mat &prevMat, const Mat &currMat, Rect *prev
         }
         else
         {
-            trackerBB = new Rect(x, y, w, h);
+            trackerRect = Rect(x, y, w, h);
+            trackerBB = &trackerRect;
         }
     }
 }
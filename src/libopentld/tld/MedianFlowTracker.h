@@ -29,13 +29,17 @@
 
 #include <opencv/cv.h>
 
+#include "FrameArena.h"
+
 namespace tld
 {
 
 class MedianFlowTracker
 {
+    cv::Rect trackerRect; //Storage of trackerBB
 public:
     cv::Rect *trackerBB;
+    FrameArena *frameArena; //Working memory of the tracker, must be set before tracking
 
     MedianFlowTracker();
     virtual ~MedianFlowTracker();
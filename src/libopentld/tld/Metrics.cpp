@@ -0,0 +1,376 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * Metrics.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "Metrics.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace tld
+{
+
+static const char *stageNames[NUM_STAGES] =
+{
+    "grey", "integral", "track", "variance", "ensemble", "nn", "clustering", "fusion", "learning", "frame"
+};
+
+static const char *counterNames[NUM_COUNTERS] =
+{
+    "windows", "variance_passed", "ensemble_passed", "nn_passed", "clusters", "reused", "arena_growth"
+};
+
+static int nextThreadSlot = 0;
+static __thread int threadSlotIndex = -1;
+
+Metrics::Metrics()
+{
+    enabled = true;
+    hardwareCounters = false;
+    ticksPerNanosecond = cvGetTickFrequency() / 1000.0; //cvGetTickFrequency() is in ticks per microsecond
+
+    void *memory = NULL;
+
+    if(posix_memalign(&memory, 64, TLD_METRICS_MAX_THREADS * sizeof(Slot)) != 0)
+    {
+        memory = NULL;
+        enabled = false;
+    }
+
+    slots = (Slot *) memory;
+    reset();
+}
+
+Metrics::~Metrics()
+{
+    free(slots);
+}
+
+void Metrics::reset()
+{
+    if(slots != NULL)
+    {
+        memset(slots, 0, TLD_METRICS_MAX_THREADS * sizeof(Slot));
+    }
+}
+
+//Threads are numbered once for all instances. With more threads than slots,
+//slots are shared, which the atomic adds keep correct.
+Metrics::Slot *Metrics::threadSlot()
+{
+    if(threadSlotIndex < 0)
+    {
+        threadSlotIndex = __sync_fetch_and_add(&nextThreadSlot, 1) % TLD_METRICS_MAX_THREADS;
+    }
+
+    return &slots[threadSlotIndex];
+}
+
+int Metrics::bucketIndex(uint64_t nanoseconds)
+{
+    if(nanoseconds < (1 << TLD_METRICS_SUB_BITS))
+    {
+        return (int) nanoseconds;
+    }
+
+    int exponent = 63 - __builtin_clzll(nanoseconds);
+    int shift = exponent - TLD_METRICS_SUB_BITS;
+    int sub = (int)(nanoseconds >> shift) & ((1 << TLD_METRICS_SUB_BITS) - 1);
+    int bucket = ((shift + 1) << TLD_METRICS_SUB_BITS) + sub;
+
+    return (bucket < TLD_METRICS_NUM_BUCKETS) ? bucket : TLD_METRICS_NUM_BUCKETS - 1;
+}
+
+//Middle of the bucket
+uint64_t Metrics::bucketValue(int bucket)
+{
+    if(bucket < (1 << TLD_METRICS_SUB_BITS))
+    {
+        return bucket;
+    }
+
+    int shift = (bucket >> TLD_METRICS_SUB_BITS) - 1;
+    uint64_t sub = bucket & ((1 << TLD_METRICS_SUB_BITS) - 1);
+    uint64_t lower = ((1ull << TLD_METRICS_SUB_BITS) + sub) << shift;
+
+    return lower + ((1ull << shift) >> 1);
+}
+
+void Metrics::addTime(int stage, uint64_t nanoseconds)
+{
+    if(!enabled) return;
+
+    Slot *slot = threadSlot();
+    __sync_fetch_and_add(&slot->count[stage], 1);
+    __sync_fetch_and_add(&slot->sum[stage], nanoseconds);
+    __sync_fetch_and_add(&slot->histogram[stage][bucketIndex(nanoseconds)], 1);
+
+    uint64_t currentMax = slot->max[stage];
+
+    while(nanoseconds > currentMax)
+    {
+        uint64_t previous = __sync_val_compare_and_swap(&slot->max[stage], currentMax, nanoseconds);
+
+        if(previous == currentMax) break;
+
+        currentMax = previous;
+    }
+}
+
+void Metrics::addTicks(int stage, tick_t begin, tick_t end)
+{
+    addTime(stage, (end > begin) ? (uint64_t)((end - begin) / ticksPerNanosecond) : 0);
+}
+
+void Metrics::addCount(int counter, uint64_t amount)
+{
+    if(!enabled) return;
+
+    __sync_fetch_and_add(&threadSlot()->counters[counter], amount);
+}
+
+void Metrics::addEvents(int stage, const uint64_t *begin, const uint64_t *end)
+{
+    if(!enabled) return;
+
+    Slot *slot = threadSlot();
+
+    for(int i = 0; i < NUM_PERF_EVENTS; i++)
+    {
+        __sync_fetch_and_add(&slot->events[stage][i], end[i] - begin[i]);
+    }
+}
+
+uint64_t Metrics::count(int stage) const
+{
+    uint64_t total = 0;
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        total += slots[i].count[stage];
+    }
+
+    return total;
+}
+
+uint64_t Metrics::counter(int counter) const
+{
+    uint64_t total = 0;
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        total += slots[i].counters[counter];
+    }
+
+    return total;
+}
+
+double Metrics::mean(int stage) const
+{
+    uint64_t n = count(stage);
+    uint64_t sum = 0;
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        sum += slots[i].sum[stage];
+    }
+
+    return (n > 0) ? (double) sum / n : 0;
+}
+
+uint64_t Metrics::max(int stage) const
+{
+    uint64_t result = 0;
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        if(slots[i].max[stage] > result) result = slots[i].max[stage];
+    }
+
+    return result;
+}
+
+uint64_t Metrics::events(int stage, int event) const
+{
+    uint64_t total = 0;
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        total += slots[i].events[stage][event];
+    }
+
+    return total;
+}
+
+void Metrics::histogram(int stage, uint64_t *buckets) const
+{
+    memset(buckets, 0, TLD_METRICS_NUM_BUCKETS * sizeof(uint64_t));
+
+    for(int i = 0; slots != NULL && i < TLD_METRICS_MAX_THREADS; i++)
+    {
+        for(int j = 0; j < TLD_METRICS_NUM_BUCKETS; j++)
+        {
+            buckets[j] += slots[i].histogram[stage][j];
+        }
+    }
+}
+
+uint64_t Metrics::percentile(int stage, double p) const
+{
+    uint64_t buckets[TLD_METRICS_NUM_BUCKETS];
+    histogram(stage, buckets);
+
+    uint64_t n = 0;
+
+    for(int j = 0; j < TLD_METRICS_NUM_BUCKETS; j++)
+    {
+        n += buckets[j];
+    }
+
+    if(n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(p * n + 0.5);
+
+    if(rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+
+    for(int j = 0; j < TLD_METRICS_NUM_BUCKETS; j++)
+    {
+        seen += buckets[j];
+
+        if(seen >= rank)
+        {
+            uint64_t value = bucketValue(j);
+            uint64_t maxValue = max(stage);
+            return (value < maxValue) ? value : maxValue;
+        }
+    }
+
+    return max(stage);
+}
+
+void Metrics::writeJSON(FILE *file) const
+{
+    fprintf(file, "{\n  \"stages\": {\n");
+
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        fprintf(file, "    \"%s\": {\"count\": %llu, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+                stageNames[i], (unsigned long long) count(i), mean(i) / 1000.0, percentile(i, 0.5) / 1000.0,
+                percentile(i, 0.9) / 1000.0, percentile(i, 0.99) / 1000.0, max(i) / 1000.0, (i + 1 < NUM_STAGES) ? "," : "");
+    }
+
+    fprintf(file, "  },\n  \"funnel\": {\n");
+
+    for(int i = 0; i < NUM_COUNTERS; i++)
+    {
+        fprintf(file, "    \"%s\": %llu%s\n", counterNames[i], (unsigned long long) counter(i), (i + 1 < NUM_COUNTERS) ? "," : "");
+    }
+
+    if(hardwareCounters)
+    {
+        fprintf(file, "  },\n  \"hardware\": {\n");
+
+        for(int i = 0; i < NUM_STAGES; i++)
+        {
+            fprintf(file, "    \"%s\": {", stageNames[i]);
+
+            for(int j = 0; j < NUM_PERF_EVENTS; j++)
+            {
+                fprintf(file, "\"%s\": %llu, ", tldPerfEventName(j), (unsigned long long) events(i, j));
+            }
+
+            uint64_t cycles = events(i, PERF_CYCLES);
+            fprintf(file, "\"ipc\": %.3f}%s\n", (cycles > 0) ? (double) events(i, PERF_INSTRUCTIONS) / cycles : 0.0,
+                    (i + 1 < NUM_STAGES) ? "," : "");
+        }
+    }
+
+    fprintf(file, "  }\n}\n");
+}
+
+void Metrics::writeCSV(FILE *file) const
+{
+    fprintf(file, "type,name,count,mean_us,p50_us,p90_us,p99_us,max_us\n");
+
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        fprintf(file, "stage,%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                stageNames[i], (unsigned long long) count(i), mean(i) / 1000.0, percentile(i, 0.5) / 1000.0,
+                percentile(i, 0.9) / 1000.0, percentile(i, 0.99) / 1000.0, max(i) / 1000.0);
+    }
+
+    for(int i = 0; i < NUM_COUNTERS; i++)
+    {
+        fprintf(file, "funnel,%s,%llu,,,,,\n", counterNames[i], (unsigned long long) counter(i));
+    }
+
+    for(int i = 0; hardwareCounters && i < NUM_STAGES; i++)
+    {
+        for(int j = 0; j < NUM_PERF_EVENTS; j++)
+        {
+            fprintf(file, "hardware,%s.%s,%llu,,,,,\n", stageNames[i], tldPerfEventName(j), (unsigned long long) events(i, j));
+        }
+    }
+}
+
+bool Metrics::dump(const char *path) const
+{
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL)
+    {
+        printf("Error: Unable to write metrics: %s\n", path);
+        return false;
+    }
+
+    size_t len = strlen(path);
+
+    if(len >= 4 && strcmp(path + len - 4, ".csv") == 0)
+    {
+        writeCSV(file);
+    }
+    else
+    {
+        writeJSON(file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+const char *Metrics::stageName(int stage)
+{
+    return stageNames[stage];
+}
+
+const char *Metrics::counterName(int counter)
+{
+    return counterNames[counter];
+}
+
+} /* namespace tld */
@@ -0,0 +1,222 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * Metrics.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <cstdio>
+
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "PerfCounters.h"
+#include "Timing.h"
+#include "Trace.h"
+
+namespace tld
+{
+
+enum MetricsStage
+{
+    STAGE_GREY,
+    STAGE_INTEGRAL,
+    STAGE_TRACK,
+    STAGE_VARIANCE,
+    STAGE_ENSEMBLE,
+    STAGE_NN,
+    STAGE_CLUSTERING,
+    STAGE_FUSION,
+    STAGE_LEARNING,
+    STAGE_FRAME, //The whole of TLD::processImage
+    NUM_STAGES
+};
+
+//Cascade funnel, summed over all frames
+enum MetricsCounter
+{
+    COUNT_WINDOWS,
+    COUNT_VARIANCE_PASSED,
+    COUNT_ENSEMBLE_PASSED,
+    COUNT_NN_PASSED,
+    COUNT_CLUSTERS,
+    COUNT_REUSED, //Windows whose outcome was taken from the previous frame
+    COUNT_ARENA_GROWTH, //Heap allocations of the frame arena (see FrameArena)
+    NUM_COUNTERS
+};
+
+//Log-linear histogram of nanoseconds: 8 buckets per power of two (12.5% resolution)
+#define TLD_METRICS_SUB_BITS 3
+#define TLD_METRICS_NUM_BUCKETS 368
+#define TLD_METRICS_MAX_THREADS 16
+
+/*
+ * Per-stage latency histograms and funnel counters.
+ * Every thread updates its own cache line aligned slot with atomic adds, so
+ * recording never takes a lock and never contends. Readers sum the slots.
+ */
+class Metrics
+{
+    struct Slot
+    {
+        uint64_t count[NUM_STAGES];
+        uint64_t sum[NUM_STAGES];
+        uint64_t max[NUM_STAGES];
+        uint64_t counters[NUM_COUNTERS];
+        uint64_t events[NUM_STAGES][NUM_PERF_EVENTS];
+        uint32_t histogram[NUM_STAGES][TLD_METRICS_NUM_BUCKETS];
+    } __attribute__((aligned(64)));
+
+    Slot *slots;
+    double ticksPerNanosecond;
+
+    Slot *threadSlot();
+    void histogram(int stage, uint64_t *buckets) const;
+
+public:
+    bool enabled;
+    bool hardwareCounters; //Also count hardware events per stage (see PerfCounters)
+
+    Metrics();
+    virtual ~Metrics();
+
+    void reset();
+    void addTime(int stage, uint64_t nanoseconds);
+    void addTicks(int stage, tick_t begin, tick_t end);
+    void addCount(int counter, uint64_t amount);
+    void addEvents(int stage, const uint64_t *begin, const uint64_t *end);
+
+    uint64_t count(int stage) const;
+    uint64_t counter(int counter) const;
+    double mean(int stage) const; //Nanoseconds
+    uint64_t max(int stage) const;
+    uint64_t percentile(int stage, double p) const; //p in [0, 1]
+    uint64_t events(int stage, int event) const; //Summed over all threads
+
+    void writeJSON(FILE *file) const;
+    void writeCSV(FILE *file) const;
+    bool dump(const char *path) const; //CSV if path ends with .csv, JSON otherwise
+
+    static const char *stageName(int stage);
+    static const char *counterName(int counter);
+    static int bucketIndex(uint64_t nanoseconds);
+    static uint64_t bucketValue(int bucket);
+};
+
+//Records the time between construction and stop() or destruction. With
+//TRACE_ENABLED, also a trace event named after the stage. With hardware
+//counters, the events of the calling thread are added to the stage.
+class MetricsTimer
+{
+    Metrics *metrics;
+    int stage;
+    tick_t begin;
+    uint64_t beginEvents[NUM_PERF_EVENTS];
+#ifdef TRACE_ENABLED
+    TraceScope trace;
+#endif
+
+public:
+    MetricsTimer(Metrics *metrics, int stage) : metrics(metrics), stage(stage)
+#ifdef TRACE_ENABLED
+        , trace(Metrics::stageName(stage))
+#endif
+    {
+        if(metrics != NULL && metrics->enabled)
+        {
+            if(metrics->hardwareCounters) tldPerfRead(beginEvents);
+
+            getCPUTick(&begin);
+        }
+        else
+        {
+            this->metrics = NULL;
+        }
+    }
+
+    ~MetricsTimer()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+#ifdef TRACE_ENABLED
+        trace.stop();
+#endif
+
+        if(metrics != NULL)
+        {
+            tick_t end;
+            getCPUTick(&end);
+            metrics->addTicks(stage, begin, end);
+
+            if(metrics->hardwareCounters)
+            {
+                uint64_t endEvents[NUM_PERF_EVENTS];
+                tldPerfRead(endEvents);
+                metrics->addEvents(stage, beginEvents, endEvents);
+            }
+
+            metrics = NULL;
+        }
+    }
+};
+
+//Adds the hardware events of an OpenMP worker thread to a stage; place it at
+//the top of a parallel region. The encountering thread (number 0) is left
+//out, the MetricsTimer around the region already counts it.
+class MetricsWorker
+{
+    Metrics *metrics;
+    int stage;
+    uint64_t beginEvents[NUM_PERF_EVENTS];
+
+public:
+    MetricsWorker(Metrics *metrics, int stage) : metrics(NULL), stage(stage)
+    {
+#ifdef _OPENMP
+        if(metrics != NULL && metrics->enabled && metrics->hardwareCounters && omp_get_thread_num() > 0)
+        {
+            this->metrics = metrics;
+            tldPerfRead(beginEvents);
+        }
+#endif
+    }
+
+    ~MetricsWorker()
+    {
+        if(metrics != NULL)
+        {
+            uint64_t endEvents[NUM_PERF_EVENTS];
+            tldPerfRead(endEvents);
+            metrics->addEvents(stage, beginEvents, endEvents);
+        }
+    }
+};
+
+} /* namespace tld */
+#endif /* METRICS_H_ */
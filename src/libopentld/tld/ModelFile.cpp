@@ -0,0 +1,289 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ModelFile.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ModelFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "NormalizedPatch.h"
+
+namespace tld
+{
+
+static uint64_t tldAlignOffset(uint64_t offset)
+{
+    return (offset + TLD_MODEL_ALIGNMENT - 1) / TLD_MODEL_ALIGNMENT * TLD_MODEL_ALIGNMENT;
+}
+
+void tldModelInitLayout(ModelFileHeader *header)
+{
+    uint64_t patchBytes = TLD_PATCH_SIZE * TLD_PATCH_SIZE * sizeof(float);
+    uint64_t tableBytes = (uint64_t) header->numTrees * header->numIndices * 4;
+
+    memcpy(header->magic, TLD_MODEL_MAGIC, sizeof(header->magic));
+    header->version = TLD_MODEL_VERSION;
+    header->headerSize = sizeof(ModelFileHeader);
+    header->patchSize = TLD_PATCH_SIZE;
+
+    uint64_t offset = tldAlignOffset(sizeof(ModelFileHeader));
+    header->truePositivesOffset = offset;
+    offset = tldAlignOffset(offset + header->numTruePositives * patchBytes);
+    header->falsePositivesOffset = offset;
+    offset = tldAlignOffset(offset + header->numFalsePositives * patchBytes);
+    header->featuresOffset = offset;
+    offset = tldAlignOffset(offset + 4 * sizeof(float) * header->numFeatures * header->numTrees);
+    header->positivesOffset = offset;
+    offset = tldAlignOffset(offset + tableBytes);
+    header->negativesOffset = offset;
+    offset = tldAlignOffset(offset + tableBytes);
+    header->posteriorsOffset = offset;
+    offset = tldAlignOffset(offset + tableBytes);
+    header->fileSize = offset;
+}
+
+void tldModelSetChecksum(void *model)
+{
+    ModelFileHeader *header = (ModelFileHeader *) model;
+    header->checksum = tldModelChecksum((const char *) model + sizeof(ModelFileHeader), header->fileSize - sizeof(ModelFileHeader));
+}
+
+//Fletcher-style checksum over 32 bit words. size must be a multiple of 4.
+uint32_t tldModelChecksum(const void *data, size_t size)
+{
+    const uint32_t *words = (const uint32_t *) data;
+    size_t numWords = size / 4;
+    uint64_t sum1 = 0;
+    uint64_t sum2 = 0;
+
+    while(numWords > 0)
+    {
+        //Blocks are small enough for the sums not to overflow before the reduction
+        size_t blockSize = (numWords < 4096) ? numWords : 4096;
+
+        for(size_t i = 0; i < blockSize; i++)
+        {
+            sum1 += words[i];
+            sum2 += sum1;
+        }
+
+        sum1 %= 0xffffffffu;
+        sum2 %= 0xffffffffu;
+        words += blockSize;
+        numWords -= blockSize;
+    }
+
+    return (uint32_t)(sum1 ^ (sum2 << 16) ^ (sum2 >> 16));
+}
+
+bool tldModelIsBinary(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    char magic[sizeof(TLD_MODEL_MAGIC)];
+    bool isBinary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, TLD_MODEL_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+
+    return isBinary;
+}
+
+ModelFile::ModelFile()
+{
+    size = 0;
+    data = NULL;
+    header = NULL;
+}
+
+ModelFile::~ModelFile()
+{
+    close();
+}
+
+bool ModelFile::open(const char *path, bool copyOnWrite)
+{
+    close();
+
+#ifdef _WIN32
+    FILE *file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        printf("Error: Model not found: %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size);
+
+    if(data == NULL || fread(data, 1, size, file) != size)
+    {
+        printf("Error: Unable to read model: %s\n", path);
+        fclose(file);
+        close();
+        return false;
+    }
+
+    fclose(file);
+#else
+    int fd = ::open(path, O_RDONLY);
+
+    if(fd < 0)
+    {
+        printf("Error: Model not found: %s\n", path);
+        return false;
+    }
+
+    struct stat st;
+
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(ModelFileHeader))
+    {
+        printf("Error: Model is truncated: %s\n", path);
+        ::close(fd);
+        return false;
+    }
+
+    size = st.st_size;
+    if(copyOnWrite)
+    {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    else
+    {
+        data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    ::close(fd); //The mapping stays valid
+
+    if(data == MAP_FAILED)
+    {
+        printf("Error: Unable to map model: %s\n", path);
+        data = NULL;
+        size = 0;
+        return false;
+    }
+
+#endif
+
+    header = (const ModelFileHeader *) data;
+
+    if(size < sizeof(ModelFileHeader) || memcmp(header->magic, TLD_MODEL_MAGIC, sizeof(header->magic)) != 0)
+    {
+        printf("Error: Not a binary model: %s\n", path);
+        close();
+        return false;
+    }
+
+    //The stored layout must be exactly the one we would write for these counts
+    ModelFileHeader expected = *header;
+    tldModelInitLayout(&expected);
+
+    if(header->version != TLD_MODEL_VERSION || header->headerSize != sizeof(ModelFileHeader) || header->patchSize != TLD_PATCH_SIZE)
+    {
+        printf("Error: Unsupported model version %u: %s\n", header->version, path);
+        close();
+        return false;
+    }
+
+    if(header->numTrees < 0 || header->numFeatures < 0 || header->numFeatures > 30 || header->numIndices != (1 << header->numFeatures)
+            || header->numTruePositives < 0 || header->numFalsePositives < 0
+            || memcmp(&expected, header, sizeof(ModelFileHeader)) != 0 || header->fileSize != size)
+    {
+        printf("Error: Model is corrupt: %s\n", path);
+        close();
+        return false;
+    }
+
+    if(tldModelChecksum((const char *) data + sizeof(ModelFileHeader), size - sizeof(ModelFileHeader)) != header->checksum)
+    {
+        printf("Error: Model checksum mismatch: %s\n", path);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void ModelFile::close()
+{
+    if(data != NULL)
+    {
+#ifdef _WIN32
+        free(data);
+#else
+        munmap(data, size);
+#endif
+    }
+
+    data = NULL;
+    size = 0;
+    header = NULL;
+}
+
+float *ModelFile::truePositives() const
+{
+    return (float *)((char *) data + header->truePositivesOffset);
+}
+
+float *ModelFile::falsePositives() const
+{
+    return (float *)((char *) data + header->falsePositivesOffset);
+}
+
+float *ModelFile::features() const
+{
+    return (float *)((char *) data + header->featuresOffset);
+}
+
+int32_t *ModelFile::positives() const
+{
+    return (int32_t *)((char *) data + header->positivesOffset);
+}
+
+int32_t *ModelFile::negatives() const
+{
+    return (int32_t *)((char *) data + header->negativesOffset);
+}
+
+float *ModelFile::posteriors() const
+{
+    return (float *)((char *) data + header->posteriorsOffset);
+}
+
+} /* namespace tld */
@@ -0,0 +1,114 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ModelFile.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef MODELFILE_H_
+#define MODELFILE_H_
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace tld
+{
+
+//Constants
+static const char TLD_MODEL_MAGIC[8] = {'T', 'L', 'D', 'M', 'O', 'D', 'E', 'L'};
+static const uint32_t TLD_MODEL_VERSION = 1;
+static const int TLD_MODEL_ALIGNMENT = 64;
+
+/*
+ * Binary model layout. The header is followed by the sections listed below,
+ * each starting at a multiple of TLD_MODEL_ALIGNMENT bytes:
+ * truePositives, falsePositives: float[num * TLD_PATCH_SIZE * TLD_PATCH_SIZE]
+ * features: float[4 * numFeatures * numTrees]
+ * positives, negatives: int32[numTrees * numIndices]
+ * posteriors: float[numTrees * numIndices]
+ * All values are stored in native byte order; a file written on a machine
+ * with a different byte order is rejected because the magic does not match.
+ */
+struct ModelFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint32_t checksum; //Checksum of everything behind the header
+    uint32_t patchSize;
+    uint64_t revision; //Incremented every time a snapshot of the same model is written
+    int32_t objWidth;
+    int32_t objHeight;
+    float minVar;
+    int32_t numTruePositives;
+    int32_t numFalsePositives;
+    int32_t numTrees;
+    int32_t numFeatures;
+    int32_t numIndices;
+    uint64_t truePositivesOffset;
+    uint64_t falsePositivesOffset;
+    uint64_t featuresOffset;
+    uint64_t positivesOffset;
+    uint64_t negativesOffset;
+    uint64_t posteriorsOffset;
+};
+
+/*
+ * Fills in magic, version and all section offsets of header. The counts
+ * (numTruePositives ... numIndices) must be set before calling this.
+ */
+void tldModelInitLayout(ModelFileHeader *header);
+uint32_t tldModelChecksum(const void *data, size_t size);
+void tldModelSetChecksum(void *model); //Checksums a complete model in memory and stores the result in its header
+bool tldModelIsBinary(const char *path);
+
+/*
+ * A binary model file mapped into memory. Pages that are never written are
+ * shared with every other mapping of the same file, in this and in other
+ * processes. If copyOnWrite is set, the mapping is private and writable:
+ * a page is copied the first time it is written, the file never changes.
+ * Otherwise the returned arrays must not be written.
+ */
+class ModelFile
+{
+    size_t size;
+    void *data;
+
+public:
+    const ModelFileHeader *header;
+
+    ModelFile();
+    virtual ~ModelFile();
+
+    bool open(const char *path, bool copyOnWrite = false);
+    void close();
+
+    float *truePositives() const;
+    float *falsePositives() const;
+    float *features() const;
+    int32_t *positives() const;
+    int32_t *negatives() const;
+    float *posteriors() const;
+};
+
+} /* namespace tld */
+#endif /* MODELFILE_H_ */
@@ -0,0 +1,518 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ModelJournal.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ModelJournal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#define fsync _commit
+#define fdatasync _commit
+#else
+#include <unistd.h>
+#endif
+
+#include "INNClassifier.h"
+#include "ModelFile.h"
+#include "TLD.h"
+
+using namespace std;
+
+namespace tld
+{
+
+//Records larger than this are treated as corrupt
+#define TLD_JOURNAL_MAX_RECORD (64 * 1024 * 1024)
+
+ModelJournal::ModelJournal()
+{
+    tld = NULL;
+    numTruePositives = 0;
+    numFalsePositives = 0;
+    snapshotRequested = false;
+    revision = 0;
+    bytesSinceSnapshot = 0;
+    running = false;
+    stopRequested = false;
+    snapshotPending = false;
+    snapshotRevision = 0;
+    failed = false;
+    journalFile = NULL;
+    compactSize = 16 * 1024 * 1024;
+    sync = false;
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+}
+
+ModelJournal::~ModelJournal()
+{
+    close();
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+//Loads the snapshot at path and replays its journal. Returns false if there
+//is no snapshot, in which case tld is left untouched.
+bool ModelJournal::restore(TLD *tld, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    ModelFileHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, TLD_MODEL_MAGIC, sizeof(header.magic)) == 0;
+    fclose(file);
+
+    if(!valid)
+    {
+        printf("Error: Not a model snapshot: %s\n", path);
+        return false;
+    }
+
+    this->tld = tld;
+    tld->readFromFile(path);
+    revision = header.revision;
+
+    string journal = string(path) + ".journal";
+    int numRecords = replay(journal.c_str());
+
+    printf("Restored model revision %llu from %s (%d journal records)\n", (unsigned long long) revision, path, numRecords);
+
+    return true;
+}
+
+//Applies all complete records. A torn record at the end (from a crash
+//while appending) ends the replay.
+int ModelJournal::replay(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        return 0;
+    }
+
+    JournalHeader header;
+
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TLD_JOURNAL_MAGIC, sizeof(header.magic)) != 0
+            || header.version != TLD_JOURNAL_VERSION || header.revision != revision)
+    {
+        //The journal belongs to an older snapshot, its changes are contained in the current one
+        fclose(file);
+        return 0;
+    }
+
+    INNClassifier *nn = tld->detectorCascade->nnClassifier;
+    IEnsembleClassifier *ec = tld->detectorCascade->ensembleClassifier;
+    int numLeaves = ec->numTrees * ec->numIndices;
+    size_t patchBytes = TLD_PATCH_SIZE * TLD_PATCH_SIZE * sizeof(float);
+    int numRecords = 0;
+    vector<char> payload;
+
+    while(true)
+    {
+        JournalRecordHeader recordHeader;
+
+        if(fread(&recordHeader, sizeof(recordHeader), 1, file) != 1)
+        {
+            break;
+        }
+
+        if(recordHeader.size == 0 || recordHeader.size > TLD_JOURNAL_MAX_RECORD)
+        {
+            printf("Warning: Invalid journal record %d in %s\n", numRecords, path);
+            break;
+        }
+
+        payload.resize(recordHeader.size);
+
+        if(fread(&payload[0], 1, payload.size(), file) != payload.size()
+                || tldModelChecksum(&payload[0], payload.size()) != recordHeader.checksum)
+        {
+            printf("Warning: Journal %s truncated after %d records\n", path, numRecords);
+            break;
+        }
+
+        if(recordHeader.type == JOURNAL_TRUE_POSITIVE || recordHeader.type == JOURNAL_FALSE_POSITIVE)
+        {
+            if(payload.size() != patchBytes)
+            {
+                break;
+            }
+
+            NormalizedPatch patch;
+            memcpy(patch.values, &payload[0], patchBytes);
+            patch.positive = recordHeader.type == JOURNAL_TRUE_POSITIVE;
+            (patch.positive) ? nn->truePositives->push_back(patch) : nn->falsePositives->push_back(patch);
+        }
+        else if(recordHeader.type == JOURNAL_LEAVES)
+        {
+            const int32_t *leaves = (const int32_t *) &payload[0];
+            size_t count = payload.size() / (3 * sizeof(int32_t));
+
+            for(size_t i = 0; i < count; i++)
+            {
+                int index = leaves[3 * i];
+
+                if(index < 0 || index >= numLeaves)
+                {
+                    continue;
+                }
+
+                int treeIdx = index / ec->numIndices;
+                int idx = index % ec->numIndices;
+                int deltaP = leaves[3 * i + 1] - ec->positives[index];
+                int deltaN = leaves[3 * i + 2] - ec->negatives[index];
+
+                if(deltaP != 0) ec->updatePosterior(treeIdx, idx, 1, deltaP);
+
+                if(deltaN != 0) ec->updatePosterior(treeIdx, idx, 0, deltaN);
+            }
+        }
+
+        numRecords++;
+    }
+
+    fclose(file);
+
+    return numRecords;
+}
+
+//Starts journaling the model of tld. The first commit writes a fresh
+//snapshot, so a journal restored before is never appended to.
+void ModelJournal::open(TLD *tld, const char *path)
+{
+    close();
+
+    this->tld = tld;
+    snapshotPath = path;
+    journalPath = snapshotPath + ".journal";
+    snapshotRequested = true;
+    stopRequested = false;
+    failed = false;
+    tld->detectorCascade->ensembleClassifier->changedLeaves = &changedLeaves;
+
+    if(pthread_create(&thread, NULL, writerThread, this) != 0)
+    {
+        printf("Error: Unable to start the journal writer\n");
+        return;
+    }
+
+    running = true;
+}
+
+//Waits for all queued changes to be written
+void ModelJournal::close()
+{
+    if(tld != NULL)
+    {
+        tld->detectorCascade->ensembleClassifier->changedLeaves = NULL;
+    }
+
+    if(running)
+    {
+        pthread_mutex_lock(&mutex);
+        stopRequested = true;
+        pthread_cond_signal(&cond);
+        pthread_mutex_unlock(&mutex);
+
+        pthread_join(thread, NULL);
+        running = false;
+    }
+
+    if(journalFile != NULL)
+    {
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+
+    changedLeaves.clear();
+}
+
+//The model was replaced as a whole, the next commit takes a snapshot
+void ModelJournal::invalidate()
+{
+    snapshotRequested = true;
+}
+
+//Called once per frame after learning
+void ModelJournal::commit()
+{
+    if(!running || !tld->detectorCascade->initialised)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+    bool stopped = failed;
+    pthread_mutex_unlock(&mutex);
+
+    if(stopped)
+    {
+        tld->detectorCascade->ensembleClassifier->changedLeaves = NULL;
+        changedLeaves.clear();
+        return;
+    }
+
+    INNClassifier *nn = tld->detectorCascade->nnClassifier;
+    IEnsembleClassifier *ec = tld->detectorCascade->ensembleClassifier;
+
+    if(snapshotRequested || nn->numTruePositives() < numTruePositives || nn->numFalsePositives() < numFalsePositives)
+    {
+        snapshot();
+        return;
+    }
+
+    record.clear();
+    size_t patchBytes = TLD_PATCH_SIZE * TLD_PATCH_SIZE * sizeof(float);
+
+    for(; numTruePositives < nn->numTruePositives(); numTruePositives++)
+    {
+        appendRecord(JOURNAL_TRUE_POSITIVE, nn->truePositive(numTruePositives), patchBytes);
+    }
+
+    for(; numFalsePositives < nn->numFalsePositives(); numFalsePositives++)
+    {
+        appendRecord(JOURNAL_FALSE_POSITIVE, nn->falsePositive(numFalsePositives), patchBytes);
+    }
+
+    if(!changedLeaves.empty())
+    {
+        sort(changedLeaves.begin(), changedLeaves.end());
+        changedLeaves.erase(unique(changedLeaves.begin(), changedLeaves.end()), changedLeaves.end());
+
+        leafPayload.resize(3 * changedLeaves.size());
+
+        for(size_t i = 0; i < changedLeaves.size(); i++)
+        {
+            int index = changedLeaves[i];
+            leafPayload[3 * i] = index;
+            leafPayload[3 * i + 1] = ec->positives[index];
+            leafPayload[3 * i + 2] = ec->negatives[index];
+        }
+
+        appendRecord(JOURNAL_LEAVES, &leafPayload[0], leafPayload.size() * sizeof(int32_t));
+        changedLeaves.clear();
+    }
+
+    if(record.empty())
+    {
+        return;
+    }
+
+    bytesSinceSnapshot += record.size();
+
+    if(bytesSinceSnapshot > compactSize)
+    {
+        snapshot();
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+    pendingDeltas.insert(pendingDeltas.end(), record.begin(), record.end());
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+void ModelJournal::appendRecord(int type, const void *payload, size_t size)
+{
+    JournalRecordHeader header;
+    header.type = type;
+    header.size = size;
+    header.checksum = tldModelChecksum(payload, size);
+    header.reserved = 0;
+
+    record.insert(record.end(), (const char *) &header, (const char *) &header + sizeof(header));
+    record.insert(record.end(), (const char *) payload, (const char *) payload + size);
+}
+
+//Copies the whole model and hands it to the writer, which adds the
+//checksum. Changes not yet written are contained in the snapshot and dropped.
+void ModelJournal::snapshot()
+{
+    tld->copyModel(serialized);
+
+    //The revision is not covered by the checksum
+    revision++;
+    ((ModelFileHeader *) &serialized[0])->revision = revision;
+
+    pthread_mutex_lock(&mutex);
+    pendingSnapshot.swap(serialized);
+    snapshotRevision = revision;
+    snapshotPending = true;
+    pendingDeltas.clear();
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    INNClassifier *nn = tld->detectorCascade->nnClassifier;
+    numTruePositives = nn->numTruePositives();
+    numFalsePositives = nn->numFalsePositives();
+    changedLeaves.clear();
+    bytesSinceSnapshot = 0;
+    snapshotRequested = false;
+}
+
+void *ModelJournal::writerThread(void *arg)
+{
+    ((ModelJournal *) arg)->writerLoop();
+    return NULL;
+}
+
+void ModelJournal::writerLoop()
+{
+    vector<char> snapshot;
+    vector<char> deltas;
+
+    pthread_mutex_lock(&mutex);
+
+    while(true)
+    {
+        while(!stopRequested && !snapshotPending && pendingDeltas.empty())
+        {
+            pthread_cond_wait(&cond, &mutex);
+        }
+
+        if(!snapshotPending && pendingDeltas.empty())
+        {
+            break;
+        }
+
+        bool haveSnapshot = snapshotPending;
+        uint64_t rev = snapshotRevision;
+        snapshotPending = false;
+        snapshot.swap(pendingSnapshot);
+        deltas.swap(pendingDeltas);
+
+        pthread_mutex_unlock(&mutex);
+
+        //Only this thread sets failed. Afterwards journalFile is NULL and
+        //everything queued is dropped.
+        if(haveSnapshot && !failed)
+        {
+            writeSnapshot(snapshot, rev);
+        }
+
+        if(!deltas.empty() && journalFile != NULL)
+        {
+            if(fwrite(&deltas[0], 1, deltas.size(), journalFile) != deltas.size() || fflush(journalFile) != 0)
+            {
+                stopWriting(journalPath.c_str());
+            }
+            else if(sync)
+            {
+                fdatasync(fileno(journalFile));
+            }
+        }
+
+        deltas.clear();
+
+        pthread_mutex_lock(&mutex);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+static bool writeFileAtomically(const string &path, const void *data, size_t size)
+{
+    string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    bool ok = fwrite(data, 1, size, file) == size && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+
+#ifdef _WIN32
+    //rename does not replace an existing file on Windows
+    return ok && MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
+//The journal of the last snapshot misses the changes that only a lost
+//snapshot or delta contained. Restoring from it would silently give another
+//model, so nothing is written anymore. Called on the writer thread.
+void ModelJournal::stopWriting(const char *what)
+{
+    printf("Error: Unable to write %s, checkpointing stopped\n", what);
+
+    if(journalFile != NULL)
+    {
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+
+    pthread_mutex_lock(&mutex);
+    failed = true;
+    pendingDeltas.clear();
+    pthread_mutex_unlock(&mutex);
+}
+
+//The snapshot replaces the old one before the journal is reset. A crash in
+//between leaves a journal of the previous revision, which replay ignores.
+bool ModelJournal::writeSnapshot(vector<char> &snapshot, uint64_t snapshotRevision)
+{
+    tldModelSetChecksum(&snapshot[0]);
+
+    if(!writeFileAtomically(snapshotPath, &snapshot[0], snapshot.size()))
+    {
+        stopWriting(snapshotPath.c_str());
+        return false;
+    }
+
+    if(journalFile != NULL)
+    {
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+
+    JournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TLD_JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = TLD_JOURNAL_VERSION;
+    header.revision = snapshotRevision;
+
+    if(!writeFileAtomically(journalPath, &header, sizeof(header)) || (journalFile = fopen(journalPath.c_str(), "ab")) == NULL)
+    {
+        stopWriting(journalPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} /* namespace tld */
@@ -0,0 +1,133 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ModelJournal.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef MODELJOURNAL_H_
+#define MODELJOURNAL_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+
+namespace tld
+{
+
+class TLD;
+
+#define TLD_JOURNAL_MAGIC "TLDJRNL"
+#define TLD_JOURNAL_VERSION 1
+
+enum JournalRecordType
+{
+    JOURNAL_TRUE_POSITIVE = 1, //float[TLD_PATCH_SIZE * TLD_PATCH_SIZE]
+    JOURNAL_FALSE_POSITIVE = 2, //float[TLD_PATCH_SIZE * TLD_PATCH_SIZE]
+    JOURNAL_LEAVES = 3 //{int32 leaf, int32 positives, int32 negatives}[]
+};
+
+struct JournalHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t revision; //Revision of the snapshot the journal applies to
+};
+
+struct JournalRecordHeader
+{
+    uint32_t type;
+    uint32_t size; //Payload bytes
+    uint32_t checksum; //tldModelChecksum of the payload
+    uint32_t reserved;
+};
+
+/*
+ * Incremental checkpoints of a learned model.
+ * path holds a full snapshot in the binary model format, path.journal an
+ * append-only list of the changes since then: new NN templates and the
+ * current counters of every changed leaf. commit() only appends the changes
+ * of the current frame to a memory buffer; writing, flushing and compaction
+ * into a new snapshot happen on a background thread. For a snapshot, the
+ * frame thread only copies the model tables; the writer checksums them.
+ * If a write fails, journaling stops with an error rather than leaving a
+ * journal that misses changes.
+ */
+class ModelJournal
+{
+    TLD *tld;
+    std::string snapshotPath;
+    std::string journalPath;
+
+    //Owned by the frame thread
+    std::vector<int> changedLeaves;
+    std::vector<int32_t> leafPayload;
+    std::vector<char> record;
+    std::vector<char> serialized;
+    int numTruePositives; //Templates already journaled
+    int numFalsePositives;
+    bool snapshotRequested;
+    uint64_t revision;
+    size_t bytesSinceSnapshot;
+
+    //Shared with the writer thread, protected by mutex
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool running;
+    bool stopRequested;
+    bool snapshotPending;
+    uint64_t snapshotRevision;
+    std::vector<char> pendingSnapshot;
+    std::vector<char> pendingDeltas;
+    bool failed; //Set by the writer after a failed write; nothing is queued anymore
+
+    //Owned by the writer thread
+    FILE *journalFile;
+
+    static void *writerThread(void *arg);
+    void writerLoop();
+    bool writeSnapshot(std::vector<char> &snapshot, uint64_t snapshotRevision);
+    void stopWriting(const char *what);
+    int replay(const char *path);
+    void appendRecord(int type, const void *payload, size_t size);
+    void snapshot();
+
+public:
+    //Configurable members
+    size_t compactSize; //A new snapshot is taken once the journal grows larger
+    bool sync; //fdatasync after every write
+
+    ModelJournal();
+    virtual ~ModelJournal();
+
+    bool restore(TLD *tld, const char *path);
+    void open(TLD *tld, const char *path);
+    void close();
+    void invalidate();
+    void commit();
+};
+
+} /* namespace tld */
+#endif /* MODELJOURNAL_H_ */
@@ -0,0 +1,192 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * PerfCounters.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "PerfCounters.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tld
+{
+
+static const char *perfEventNames[NUM_PERF_EVENTS] =
+{
+    "cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses"
+};
+
+#ifdef __linux__
+
+static const uint32_t perfEventTypes[NUM_PERF_EVENTS] =
+{
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+};
+
+static const uint64_t perfEventConfigs[NUM_PERF_EVENTS] =
+{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+
+//Events from this one on are left out of the group if they cannot be opened
+#define PERF_FIRST_OPTIONAL_EVENT PERF_DTLB_MISSES
+
+static __thread int perfGroup = -2; //-2: not opened yet, -1: unavailable
+static __thread int perfNumEvents; //Members of the group, the optional events that could not be opened are missing
+static __thread uint64_t perfLast[3 + NUM_PERF_EVENTS];
+static __thread uint64_t perfTotal[NUM_PERF_EVENTS];
+static bool perfWarned = false;
+
+static int perfOpen(int event, int group)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perfEventTypes[event];
+    attr.config = perfEventConfigs[event];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    //This thread only, on any CPU
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void perfOpenGroup()
+{
+    int members[NUM_PERF_EVENTS]; //The members of a working group stay open as long as the thread
+    perfGroup = perfOpen(0, -1);
+    perfNumEvents = 1;
+
+    for(int i = 1; i < NUM_PERF_EVENTS && perfGroup >= 0; i++)
+    {
+        members[i] = perfOpen(i, perfGroup);
+
+        if(members[i] >= 0)
+        {
+            perfNumEvents++;
+        }
+        else if(i >= PERF_FIRST_OPTIONAL_EVENT)
+        {
+            break; //Counted as 0, like the optional events after it
+        }
+        else
+        {
+            for(int j = 1; j < i; j++)
+            {
+                close(members[j]);
+            }
+
+            close(perfGroup);
+            perfGroup = -1;
+        }
+    }
+
+    if(perfGroup < 0)
+    {
+        if(!perfWarned)
+        {
+            perfWarned = true;
+            printf("Warning: Hardware performance counters are not available (see /proc/sys/kernel/perf_event_paranoid)\n");
+        }
+
+        return;
+    }
+
+    memset(perfLast, 0, sizeof(perfLast));
+    memset(perfTotal, 0, sizeof(perfTotal));
+}
+
+bool tldPerfRead(uint64_t values[NUM_PERF_EVENTS])
+{
+    if(perfGroup == -2)
+    {
+        perfOpenGroup();
+    }
+
+    //nr, time enabled, time running, values
+    uint64_t buffer[3 + NUM_PERF_EVENTS];
+    memset(buffer, 0, sizeof(buffer));
+    ssize_t size = (3 + perfNumEvents) * sizeof(uint64_t);
+
+    if(perfGroup < 0 || read(perfGroup, buffer, size) != size)
+    {
+        memset(values, 0, NUM_PERF_EVENTS * sizeof(uint64_t));
+        return false;
+    }
+
+    //Scale what was counted since the last read by the share of the time the
+    //group was actually on the PMU, and accumulate.
+    uint64_t enabled = buffer[1] - perfLast[1];
+    uint64_t running = buffer[2] - perfLast[2];
+
+    for(int i = 0; i < NUM_PERF_EVENTS; i++)
+    {
+        uint64_t delta = buffer[3 + i] - perfLast[3 + i];
+
+        if(running > 0 && running < enabled)
+        {
+            delta = (uint64_t)((double) delta * enabled / running);
+        }
+
+        perfTotal[i] += delta;
+        values[i] = perfTotal[i];
+    }
+
+    memcpy(perfLast, buffer, sizeof(buffer));
+    return true;
+}
+
+bool tldPerfAvailable()
+{
+    uint64_t values[NUM_PERF_EVENTS];
+    return tldPerfRead(values);
+}
+
+#else
+
+bool tldPerfRead(uint64_t values[NUM_PERF_EVENTS])
+{
+    memset(values, 0, NUM_PERF_EVENTS * sizeof(uint64_t));
+    return false;
+}
+
+bool tldPerfAvailable()
+{
+    return false;
+}
+
+#endif
+
+const char *tldPerfEventName(int event)
+{
+    return perfEventNames[event];
+}
+
+} /* namespace tld */
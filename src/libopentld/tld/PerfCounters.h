@@ -0,0 +1,56 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * PerfCounters.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include <stdint.h>
+
+namespace tld
+{
+
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES, //Data TLB load misses; optional, stays 0 where the PMU does not count them
+    NUM_PERF_EVENTS
+};
+
+/*
+ * Hardware performance counters of the calling thread, via perf_event_open.
+ * The counters of a thread are opened as one group the first time the thread
+ * reads them and stay open for the lifetime of the thread. If the group was
+ * multiplexed with other users of the PMU, values are scaled to the full time.
+ * Returns false if counters are not available (not Linux, no PMU, or
+ * forbidden by /proc/sys/kernel/perf_event_paranoid).
+ */
+bool tldPerfRead(uint64_t values[NUM_PERF_EVENTS]);
+bool tldPerfAvailable();
+const char *tldPerfEventName(int event);
+
+} /* namespace tld */
+#endif /* PERFCOUNTERS_H_ */
@@ -28,8 +28,10 @@
 #include <iostream>
 
 #include "INNClassifier.h"
+#include "ModelFile.h"
+#include "ModelJournal.h"
 #include "TLDUtil.h"
-#include "Timing.h"
+#include "Trace.h"
 
 #ifdef CUDA_ENABLED
 #include "CuDetectorCascade.h"
@@ -50,6 +52,11 @@ TLD::TLD()
     detectorEnabled = true;
     learningEnabled = true;
     alternating = false;
+    shareModel = false;
+    modelFile = NULL;
+    journal = NULL;
+    metrics = new Metrics();
+    frameArena = new FrameArena();
     valid = false;
     wasValid = false;
     learning = false;
@@ -61,8 +68,11 @@ TLD::TLD()
     detectorCascade = new DetectorCascade();
 #endif
     nnClassifier = detectorCascade->nnClassifier;
+    detectorCascade->metrics = metrics;
+    detectorCascade->frameArena = frameArena;
 
     medianFlowTracker = new MedianFlowTracker();
+    medianFlowTracker->frameArena = frameArena;
 }
 
 TLD::~TLD()
@@ -71,21 +81,38 @@ TLD::~TLD()
 
     delete detectorCascade;
     delete medianFlowTracker;
+    delete modelFile;
+    delete metrics;
+    delete frameArena;
 }
 
 void TLD::release()
 {
     detectorCascade->release();
+    releaseModelFile();
     medianFlowTracker->cleanPreviousData();
-    delete currBB;
+    currBB = NULL;
+
+    if(journal != NULL)
+    {
+        journal->invalidate();
+    }
+}
+
+//Must be called after the detector cascade has been released
+void TLD::releaseModelFile()
+{
+    delete modelFile;
+    modelFile = NULL;
 }
 
 void TLD::storeCurrentData()
 {
-    prevImg.release();
+    spareImg = prevImg; //Its buffer is reused by convertToGrey
     prevImg = currImg; //Store old image (if any)
-    delete prevBB;
-    prevBB = currBB;        //Store old bounding box (if any)
+    prevBB = (currBB != NULL) ? &prevRect : NULL; //Store old bounding box (if any)
+
+    if(currBB != NULL) prevRect = *currBB;
 
     detectorCascade->cleanPreviousData(); //Reset detector results
     medianFlowTracker->cleanPreviousData();
@@ -97,6 +124,7 @@ void TLD::selectObject(const Mat &img, Rect *bb)
 {
     //Delete old object
     detectorCascade->release();
+    releaseModelFile();
 
     detectorCascade->objWidth = bb->width;
     detectorCascade->objHeight = bb->height;
@@ -104,44 +132,97 @@ void TLD::selectObject(const Mat &img, Rect *bb)
     //Init detector cascade
     detectorCascade->init();
 
-    currImg = img;
-    currBB = tldCopyRect(bb);
+    currImg = img.clone(); //img may be the caller's buffer, which changes after this call
+    currRect = *bb;
+    currBB = &currRect;
     currConf = 1;
     valid = true;
 
     initialLearning();
+    frameArena->reset();
+
+    if(journal != NULL)
+    {
+        journal->invalidate();
+        journal->commit();
+    }
+}
+
+Mat TLD::convertToGrey(const Mat &img)
+{
+    MetricsTimer greyTimer(metrics, STAGE_GREY);
+    Mat grey;
+
+    //Reuse the buffer of a frame the tracker no longer reads, unless it is
+    //still referenced from outside
+    if(spareImg.refcount != NULL && *spareImg.refcount == 1)
+    {
+        grey = spareImg;
+    }
+
+    spareImg.release();
+
+    if(img.channels() == 1)
+    {
+        img.copyTo(grey);
+    }
+    else
+    {
+        cvtColor(img, grey, CV_BGR2GRAY);
+    }
 
+    return grey;
 }
 
 void TLD::processImage(const Mat &img)
 {
-    tick_t procInit, procFinal;
+    MetricsTimer frameTimer(metrics, STAGE_FRAME);
     storeCurrentData();
     Mat grey_frame;
-    cvtColor(img, grey_frame, CV_RGB2GRAY);
+
+    if(img.channels() == 1 && img.refcount != NULL && img.isContinuous())
+    {
+        //Shared with the caller, who must not write into it afterwards
+        grey_frame = img;
+    }
+    else
+    {
+        //Headers over foreign data may be overwritten before the tracker
+        //reads them as prevImg
+        grey_frame = convertToGrey(img);
+    }
+
     currImg = grey_frame; // Store new image , right after storeCurrentData();
 
     if(trackerEnabled)
     {
-        getCPUTick(&procInit);
+        MetricsTimer trackTimer(metrics, STAGE_TRACK);
         medianFlowTracker->track(prevImg, currImg, prevBB);
-        getCPUTick(&procFinal);
-        PRINT_TIMING("TrackTime", procInit, procFinal, ", ");
     }
 
     if(detectorEnabled && (!alternating || medianFlowTracker->trackerBB == NULL))
     {
-        getCPUTick(&procInit);
+        TLD_TRACE_SCOPE("detect");
         detectorCascade->detect(grey_frame);
-        getCPUTick(&procFinal);
-        PRINT_TIMING("DetecTime", procInit, procFinal, ", ");
     }
 
-
+    MetricsTimer fusionTimer(metrics, STAGE_FUSION);
     fuseHypotheses();
+    fusionTimer.stop();
 
     learn();
 
+    if(journal != NULL)
+    {
+        journal->commit();
+    }
+
+    //All temporaries of this frame are given back at once. The arena only
+    //grows while it has not yet seen the largest frame.
+    uint64_t numHeapAllocations = frameArena->numHeapAllocations;
+    frameArena->reset();
+    metrics->addCount(COUNT_ARENA_GROWTH, frameArena->numHeapAllocations - numHeapAllocations);
+
 }
 
 void TLD::fuseHypotheses()
@@ -169,12 +250,14 @@ void TLD::fuseHypotheses()
         if(numClusters == 1 && confDetector > confTracker && tldOverlapRectRect(*trackerBB, *detectorBB) < 0.5)
         {
 
-            currBB = tldCopyRect(detectorBB);
+            currRect = *detectorBB;
+            currBB = &currRect;
             currConf = confDetector;
         }
         else
         {
-            currBB = tldCopyRect(trackerBB);
+            currRect = *trackerBB;
+            currBB = &currRect;
             currConf = confTracker;
 
             if(confTracker > nnClassifier->thetaTP)
@@ -189,7 +272,8 @@ void TLD::fuseHypotheses()
     }
     else if(numClusters == 1)
     {
-        currBB = tldCopyRect(detectorBB);
+        currRect = *detectorBB;
+        currBB = &currRect;
         currConf = confDetector;
     }
 
@@ -202,13 +286,64 @@ void TLD::fuseHypotheses()
     }*/
 }
 
+//Tells whether window i is one of the ascending overlapping windows. next is
+//advanced past the ones before i, so asking for ascending windows visits the
+//list once.
+static bool isOverlapping(const vector<pair<int, float> > &overlapping, size_t *next, int i)
+{
+    while(*next < overlapping.size() && overlapping[*next].first < i)
+    {
+        (*next)++;
+    }
+
+    return *next < overlapping.size() && overlapping[*next].first == i;
+}
+
+//Appends negative patches of the first count windows, extracted in parallel
+static void addNegativePatches(const Mat &img, const WindowGrid &windowGrid, const vector<int> &windowIndices, size_t count, vector<NormalizedPatch> *patches)
+{
+    size_t first = patches->size();
+    patches->resize(first + count);
+
+    #pragma omp parallel for
+    for(int i = 0; i < (int) count; i++)
+    {
+        int bb[TLD_WINDOW_SIZE];
+        windowGrid.window(windowIndices[i], bb);
+
+        NormalizedPatch &patch = (*patches)[first + i];
+        tldExtractNormalizedPatchBB(img, bb, patch.values);
+        patch.positive = 0;
+    }
+}
+
+//The first count windows of the sorted overlapping ones
+static void firstIndices(const vector<pair<int, float> > &overlapping, size_t count, vector<int> *indices)
+{
+    indices->resize(count);
+
+    for(size_t i = 0; i < count; i++)
+    {
+        (*indices)[i] = overlapping[i].first;
+    }
+}
+
 void TLD::initialLearning()
 {
     learning = true; //This is just for display purposes
 
     DetectionResult *detectionResult = detectorCascade->detectionResult;
 
+    //Negatives are taken from the whole image, not only from the foreground
+    //or from the neighbourhood of coarse windows
+    ForegroundDetector *foregroundDetector = detectorCascade->foregroundDetector;
+    bool foregroundEnabled = foregroundDetector->enabled;
+    int coarseStep = detectorCascade->coarseStep;
+    foregroundDetector->enabled = false;
+    detectorCascade->coarseStep = 1;
     detectorCascade->detect(currImg);
+    foregroundDetector->enabled = foregroundEnabled;
+    detectorCascade->coarseStep = coarseStep;
 
     //This is the positive patch
     NormalizedPatch patch;
@@ -219,25 +354,31 @@ void TLD::initialLearning()
     detectorCascade->varianceFilter->minVar = initVar / 2;
 
 
-    float *overlap = new float[detectorCascade->numWindows];
-    tldOverlapRect(detectorCascade->windows, detectorCascade->numWindows, currBB, overlap);
+    //Only windows near the object are visited; all others overlap less than 0.2
+    overlapping.clear();
+    tldOverlapping(&detectorCascade->windowGrid, currBB, 0.2, &overlapping);
 
     //Add all bounding boxes with high overlap
 
-    vector< pair<int, float> > positiveIndices;
-    vector<int> negativeIndices;
+    positiveIndices.clear();
+    negativeIndices.clear();
 
     //First: Find overlapping positive and negative patches
 
-    for(int i = 0; i < detectorCascade->numWindows; i++)
+    for(size_t i = 0; i < overlapping.size(); i++)
     {
-
-        if(overlap[i] > 0.6)
+        if(overlapping[i].second > 0.6)
         {
-            positiveIndices.push_back(pair<int, float>(i, overlap[i]));
+            positiveIndices.push_back(overlapping[i]);
         }
+    }
+
+    //Negatives come from all other windows
+    size_t next = 0;
 
-        if(overlap[i] < 0.2)
+    for(int i = 0; i < detectorCascade->numWindows; i++)
+    {
+        if(!isOverlapping(overlapping, &next, i))
         {
             float variance = detectionResult->variances[i];
 
@@ -250,38 +391,27 @@ void TLD::initialLearning()
 
     sort(positiveIndices.begin(), positiveIndices.end(), tldSortByOverlapDesc);
 
-    vector<NormalizedPatch> patches;
+    patches.clear();
 
     patches.push_back(patch); //Add first patch to patch list
 
     int numIterations = std::min<size_t>(positiveIndices.size(), 10); //Take at most 10 bounding boxes (sorted by overlap)
 
-    for(int i = 0; i < numIterations; i++)
-    {
-        int idx = positiveIndices.at(i).first;
-        //Learn this bounding box
-        //TODO: Somewhere here image warping might be possible
-        detectorCascade->ensembleClassifier->learn(&detectorCascade->windows[TLD_WINDOW_SIZE * idx], true, &detectionResult->featureVectors[detectorCascade->numTrees * idx]);
-    }
+    //Learn these bounding boxes
+    //TODO: Somewhere here image warping might be possible
+    firstIndices(positiveIndices, numIterations, &positiveWindows);
+    detectorCascade->ensembleClassifier->learn(positiveWindows, true);
 
     srand(1); //TODO: This is not guaranteed to affect random_shuffle
 
     random_shuffle(negativeIndices.begin(), negativeIndices.end());
 
     //Choose 100 random patches for negative examples
-    for(size_t i = 0; i < std::min<size_t>(100, negativeIndices.size()); i++)
-    {
-        int idx = negativeIndices.at(i);
-
-        NormalizedPatch patch;
-        tldExtractNormalizedPatchBB(currImg, &detectorCascade->windows[TLD_WINDOW_SIZE * idx], patch.values);
-        patch.positive = 0;
-        patches.push_back(patch);
-    }
+    addNegativePatches(currImg, detectorCascade->windowGrid, negativeIndices, std::min<size_t>(100, negativeIndices.size()), &patches);
 
     detectorCascade->nnClassifier->learn(patches);
+    detectorCascade->invalidateResults();
 
-    delete[] overlap;
 
 }
 
@@ -296,6 +426,8 @@ void TLD::learn()
 
     learning = true;
 
+    MetricsTimer learningTimer(metrics, STAGE_LEARNING);
+
     DetectionResult *detectionResult = detectorCascade->detectionResult;
 
     if(!detectionResult->containsValidData)
@@ -303,30 +435,47 @@ void TLD::learn()
         detectorCascade->detect(currImg);
     }
 
+    //Learning often leaves the model as it is; results of this frame can
+    //then be reused in the next one
+    unsigned int numUpdates = detectorCascade->ensembleClassifier->numUpdates;
+    int numTemplates = detectorCascade->nnClassifier->numTruePositives() + detectorCascade->nnClassifier->numFalsePositives();
+
     //This is the positive patch
     NormalizedPatch patch;
     tldExtractNormalizedPatchRect(currImg, currBB, patch.values);
 
-    float *overlap = new float[detectorCascade->numWindows];
-    tldOverlapRect(detectorCascade->windows, detectorCascade->numWindows, currBB, overlap);
+    //Only windows near the object are visited; all others overlap less than 0.2
+    overlapping.clear();
+    tldOverlapping(&detectorCascade->windowGrid, currBB, 0.2, &overlapping);
 
     //Add all bounding boxes with high overlap
 
-    vector<pair<int, float> > positiveIndices;
-    vector<int> negativeIndices;
-    vector<int> negativeIndicesForNN;
+    positiveIndices.clear();
+    negativeIndices.clear();
+    negativeIndicesForNN.clear();
 
     //First: Find overlapping positive and negative patches
 
-    for(int i = 0; i < detectorCascade->numWindows; i++)
+    for(size_t i = 0; i < overlapping.size(); i++)
     {
-
-        if(overlap[i] > 0.6)
+        if(overlapping[i].second > 0.6)
         {
-            positiveIndices.push_back(pair<int, float>(i, overlap[i]));
+            positiveIndices.push_back(overlapping[i]);
         }
+    }
+
+    //Negatives come from the other windows. Only windows that passed the
+    //variance filter have a posterior, so with the ensemble classifier
+    //enabled no other window can be one.
+    const vector<int> *candidates = detectorCascade->ensembleClassifier->enabled ? detectionResult->varianceIndices : NULL;
+    int numCandidates = (candidates != NULL) ? candidates->size() : detectorCascade->numWindows;
+    size_t next = 0;
+
+    for(int k = 0; k < numCandidates; k++)
+    {
+        int i = (candidates != NULL) ? (*candidates)[k] : k;
 
-        if(overlap[i] < 0.2)
+        if(!isOverlapping(overlapping, &next, i))
         {
             if(!detectorCascade->ensembleClassifier->enabled || detectionResult->posteriors[i] > 0.1)   //TODO: Shouldn't this read as 0.5?
             {
@@ -343,7 +492,7 @@ void TLD::learn()
 
     sort(positiveIndices.begin(), positiveIndices.end(), tldSortByOverlapDesc);
 
-    vector<NormalizedPatch> patches;
+    patches.clear();
 
     patch.positive = 1;
     patches.push_back(patch);
@@ -352,36 +501,26 @@ void TLD::learn()
 
     int numIterations = std::min<size_t>(positiveIndices.size(), 10); //Take at most 10 bounding boxes (sorted by overlap)
 
-    for(size_t i = 0; i < negativeIndices.size(); i++)
-    {
-        int idx = negativeIndices.at(i);
-        //TODO: Somewhere here image warping might be possible
-        detectorCascade->ensembleClassifier->learn(&detectorCascade->windows[TLD_WINDOW_SIZE * idx], false, &detectionResult->featureVectors[detectorCascade->numTrees * idx]);
-    }
+    //TODO: Somewhere here image warping might be possible
+    detectorCascade->ensembleClassifier->learn(negativeIndices, false);
 
     //TODO: Randomization might be a good idea
-    for(int i = 0; i < numIterations; i++)
-    {
-        int idx = positiveIndices.at(i).first;
-        //TODO: Somewhere here image warping might be possible
-        detectorCascade->ensembleClassifier->learn(&detectorCascade->windows[TLD_WINDOW_SIZE * idx], true, &detectionResult->featureVectors[detectorCascade->numTrees * idx]);
-    }
+    firstIndices(positiveIndices, numIterations, &positiveWindows);
+    detectorCascade->updateFeatureVectors(positiveWindows);
+    detectorCascade->ensembleClassifier->learn(positiveWindows, true);
 
-    for(size_t i = 0; i < negativeIndicesForNN.size(); i++)
-    {
-        int idx = negativeIndicesForNN.at(i);
-
-        NormalizedPatch patch;
-        tldExtractNormalizedPatchBB(currImg, &detectorCascade->windows[TLD_WINDOW_SIZE * idx], patch.values);
-        patch.positive = 0;
-        patches.push_back(patch);
-    }
+    addNegativePatches(currImg, detectorCascade->windowGrid, negativeIndicesForNN, negativeIndicesForNN.size(), &patches);
 
     detectorCascade->nnClassifier->learn(patches);
 
+    if(detectorCascade->ensembleClassifier->numUpdates != numUpdates
+            || detectorCascade->nnClassifier->numTruePositives() + detectorCascade->nnClassifier->numFalsePositives() != numTemplates)
+    {
+        detectorCascade->invalidateResults();
+    }
+
     //cout << "NN has now " << detectorCascade->nnClassifier->truePositives->size() << " positives and " << detectorCascade->nnClassifier->falsePositives->size() << " negatives.\n";
 
-    delete[] overlap;
 }
 
 typedef struct
@@ -401,13 +540,13 @@ void TLD::writeToFile(const char *path)
     fprintf(file, "%d #width\n", detectorCascade->objWidth);
     fprintf(file, "%d #height\n", detectorCascade->objHeight);
     fprintf(file, "%f #min_var\n", detectorCascade->varianceFilter->minVar);
-    fprintf(file, "%d #Positive Sample Size\n", nn->truePositives->size());
+    fprintf(file, "%d #Positive Sample Size\n", nn->numTruePositives());
 
 
 
-    for(size_t s = 0; s < nn->truePositives->size(); s++)
+    for(int s = 0; s < nn->numTruePositives(); s++)
     {
-        float *imageData = nn->truePositives->at(s).values;
+        const float *imageData = nn->truePositive(s);
 
         for(int i = 0; i < TLD_PATCH_SIZE; i++)
         {
@@ -420,11 +559,11 @@ void TLD::writeToFile(const char *path)
         }
     }
 
-    fprintf(file, "%d #Negative Sample Size\n", nn->falsePositives->size());
+    fprintf(file, "%d #Negative Sample Size\n", nn->numFalsePositives());
 
-    for(size_t s = 0; s < nn->falsePositives->size(); s++)
+    for(int s = 0; s < nn->numFalsePositives(); s++)
     {
-        float *imageData = nn->falsePositives->at(s).values;
+        const float *imageData = nn->falsePositive(s);
 
         for(int i = 0; i < TLD_PATCH_SIZE; i++)
         {
@@ -484,6 +623,12 @@ void TLD::writeToFile(const char *path)
 
 void TLD::readFromFile(const char *path)
 {
+    if(tldModelIsBinary(path))
+    {
+        readFromBinaryFile(path);
+        return;
+    }
+
     release();
 
     INNClassifier *nn = detectorCascade->nnClassifier;
@@ -611,15 +756,172 @@ void TLD::readFromFile(const char *path)
         }
     }
 
+    initDetectorFromModel();
+}
+
+void TLD::initDetectorFromModel()
+{
     detectorCascade->initWindowsAndScales();
-    detectorCascade->initWindowOffsets();
 
     detectorCascade->propagateMembers();
 
     detectorCascade->initialised = true;
 
-    ec->initFeatureOffsets();
+    detectorCascade->ensembleClassifier->initFeatureOffsets();
+}
+
+//Serializes the model in the binary format described in ModelFile.h
+void TLD::copyModel(vector<char> &buffer)
+{
+    INNClassifier *nn = detectorCascade->nnClassifier;
+    IEnsembleClassifier *ec = detectorCascade->ensembleClassifier;
+
+    ModelFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.objWidth = detectorCascade->objWidth;
+    header.objHeight = detectorCascade->objHeight;
+    header.minVar = detectorCascade->varianceFilter->minVar;
+    header.numTruePositives = nn->numTruePositives();
+    header.numFalsePositives = nn->numFalsePositives();
+    header.numTrees = ec->numTrees;
+    header.numFeatures = ec->numFeatures;
+    header.numIndices = ec->numIndices;
+    tldModelInitLayout(&header);
+
+    buffer.assign(header.fileSize, 0);
+    char *data = &buffer[0];
+    size_t patchBytes = TLD_PATCH_SIZE * TLD_PATCH_SIZE * sizeof(float);
+    size_t tableBytes = ec->numTrees * ec->numIndices * sizeof(int);
+
+    for(int i = 0; i < header.numTruePositives; i++)
+    {
+        memcpy(data + header.truePositivesOffset + i * patchBytes, nn->truePositive(i), patchBytes);
+    }
+
+    for(int i = 0; i < header.numFalsePositives; i++)
+    {
+        memcpy(data + header.falsePositivesOffset + i * patchBytes, nn->falsePositive(i), patchBytes);
+    }
+
+    if(ec->features != NULL)
+    {
+        memcpy(data + header.featuresOffset, ec->features, 4 * sizeof(float) * ec->numFeatures * ec->numTrees);
+    }
+
+    if(ec->posteriors != NULL)
+    {
+        memcpy(data + header.positivesOffset, ec->positives, tableBytes);
+        memcpy(data + header.negativesOffset, ec->negatives, tableBytes);
+        memcpy(data + header.posteriorsOffset, ec->posteriors, tableBytes);
+    }
+
+    memcpy(data, &header, sizeof(header));
+}
+
+void TLD::serializeModel(vector<char> &buffer)
+{
+    copyModel(buffer);
+    tldModelSetChecksum(&buffer[0]);
+}
+
+void TLD::writeToBinaryFile(const char *path)
+{
+    vector<char> buffer;
+    serializeModel(buffer);
+
+    FILE *file = fopen(path, "wb");
+
+    if(file == NULL || fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+    {
+        printf("Error: Unable to write model: %s\n", path);
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+    }
+}
+
+void TLD::readFromBinaryFile(const char *path)
+{
+    release();
+
+    INNClassifier *nn = detectorCascade->nnClassifier;
+    IEnsembleClassifier *ec = detectorCascade->ensembleClassifier;
+
+    //A shared model stays mapped as long as the detector uses it. Learning
+    //writes go to private copies of the touched pages only.
+    ModelFile localModel;
+    ModelFile *model = &localModel;
+
+    if(shareModel)
+    {
+        modelFile = new ModelFile();
+        model = modelFile;
+    }
+
+    if(!model->open(path, shareModel))
+    {
+        exit(1);
+    }
+
+    const ModelFileHeader *header = model->header;
+    size_t patchValues = TLD_PATCH_SIZE * TLD_PATCH_SIZE;
+    size_t tableBytes = header->numTrees * header->numIndices * sizeof(int);
+
+    detectorCascade->objWidth = header->objWidth;
+    detectorCascade->objHeight = header->objHeight;
+    detectorCascade->varianceFilter->minVar = header->minVar;
+
+    ec->numTrees = detectorCascade->numTrees = header->numTrees;
+    ec->numFeatures = detectorCascade->numFeatures = header->numFeatures;
+    ec->numIndices = header->numIndices;
+
+    if(shareModel)
+    {
+        nn->sharedTruePositives = model->truePositives();
+        nn->numSharedTruePositives = header->numTruePositives;
+        nn->sharedFalsePositives = model->falsePositives();
+        nn->numSharedFalsePositives = header->numFalsePositives;
+
+        ec->sharedModel = true;
+        ec->features = model->features();
+        ec->positives = model->positives();
+        ec->negatives = model->negatives();
+        ec->posteriors = model->posteriors();
+
+        initDetectorFromModel();
+        return;
+    }
+
+    nn->truePositives->resize(header->numTruePositives);
+
+    for(int i = 0; i < header->numTruePositives; i++)
+    {
+        NormalizedPatch &patch = nn->truePositives->at(i);
+        memcpy(patch.values, model->truePositives() + i * patchValues, patchValues * sizeof(float));
+        patch.positive = true;
+    }
+
+    nn->falsePositives->resize(header->numFalsePositives);
+
+    for(int i = 0; i < header->numFalsePositives; i++)
+    {
+        NormalizedPatch &patch = nn->falsePositives->at(i);
+        memcpy(patch.values, model->falsePositives() + i * patchValues, patchValues * sizeof(float));
+        patch.positive = false;
+    }
+
+    ec->features = new float[4 * ec->numFeatures * ec->numTrees];
+    memcpy(ec->features, model->features(), 4 * sizeof(float) * ec->numFeatures * ec->numTrees);
+
+    //The posterior tables are copied as they are, no need to replay the leaves
+    ec->initPosteriors();
+    memcpy(ec->positives, model->positives(), tableBytes);
+    memcpy(ec->negatives, model->negatives(), tableBytes);
+    memcpy(ec->posteriors, model->posteriors(), tableBytes);
 
+    initDetectorFromModel();
 }
 
 
@@ -27,33 +27,60 @@
 #ifndef TLD_H_
 #define TLD_H_
 
+#include <vector>
+
 #include <opencv/cv.h>
 
 #include "MedianFlowTracker.h"
 #include "IDetectorCascade.h"
+#include "FrameArena.h"
+#include "Metrics.h"
+#include "NormalizedPatch.h"
 
 namespace tld
 {
 
+class ModelFile;
+class ModelJournal;
+
 class TLD
 {
+    cv::Rect prevRect; //Storage of prevBB
+    cv::Rect currRect; //Storage of currBB
+
+    //Working memory of learning, kept between frames
+    std::vector<std::pair<int, float> > overlapping;
+    std::vector<std::pair<int, float> > positiveIndices;
+    std::vector<int> positiveWindows;
+    std::vector<int> negativeIndices;
+    std::vector<int> negativeIndicesForNN;
+    std::vector<NormalizedPatch> patches;
+
     void storeCurrentData();
     void fuseHypotheses();
     void learn();
     void initialLearning();
+    void initDetectorFromModel();
+    void releaseModelFile();
 public:
     bool trackerEnabled;
     bool detectorEnabled;
     bool learningEnabled;
     bool alternating;
+    bool shareModel; //Run directly from a mapped binary model instead of a private copy
 
     MedianFlowTracker *medianFlowTracker;
     IDetectorCascade *detectorCascade;
     INNClassifier *nnClassifier;
+    ModelFile *modelFile; //Mapping of the shared model, if any
+    Metrics *metrics; //Stage timings and cascade funnel, shared with the detector cascade
+    FrameArena *frameArena; //Temporaries of the current frame, shared with the tracker and the detector cascade
+    ModelJournal *journal; //Receives the model changes of every frame, if set. Not owned.
     bool valid;
     bool wasValid;
     cv::Mat prevImg;
     cv::Mat currImg;
+    cv::Mat spareImg; //Buffer of the image before prevImg, recycled by convertToGrey
     cv::Rect *prevBB;
     cv::Rect *currBB;
     float currConf;
@@ -63,9 +90,17 @@ public:
     virtual ~TLD();
     void release();
     void selectObject(const cv::Mat &img, cv::Rect *bb);
+    //Converts a BGR or grey image into a grey buffer that processImage keeps without a copy
+    cv::Mat convertToGrey(const cv::Mat &img);
+    //img is BGR or grey. Grey images that own continuous data are kept without a copy and must not be written
+    //into afterwards.
     void processImage(const cv::Mat &img);
     void writeToFile(const char *path);
     void readFromFile(const char *path);
+    void copyModel(std::vector<char> &buffer); //Binary layout without the checksum, see tldModelSetChecksum
+    void serializeModel(std::vector<char> &buffer);
+    void writeToBinaryFile(const char *path);
+    void readFromBinaryFile(const char *path);
 };
 
 } /* namespace tld */
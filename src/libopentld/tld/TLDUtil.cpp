@@ -51,7 +51,9 @@ void tldNormalizeImg(const Mat &img, float *output)
 {
     int size = TLD_PATCH_SIZE;
 
-    Mat result;
+    //The patch is small enough for the stack
+    unsigned char resultData[TLD_PATCH_SIZE * TLD_PATCH_SIZE];
+    Mat result(size, size, CV_8UC1, resultData);
     resize(img, result, cvSize(size, size)); //Default is bilinear
 
     float mean = 0;
@@ -96,9 +98,8 @@ void tldExtractSubImage(const Mat &img, Mat &subImage, int *boundary)
 
 void tldExtractNormalizedPatch(const Mat &img, int x, int y, int w, int h, float *output)
 {
-    Mat subImage;
-    tldExtractSubImage(img, subImage, Rect(x, y, w, h));
-    tldNormalizeImg(subImage, output);
+    //Only a header of the region, the pixels are not copied
+    tldNormalizeImg(img(Rect(x, y, w, h)), output);
 }
 
 //TODO: Rename
@@ -174,13 +175,16 @@ float tldBBOverlap(int *bb1, int *bb2)
     return intersection / (float)(area1 + area2 - intersection);
 }
 
-void tldOverlapOne(int *windows, int numWindows, int index, vector<int> * indices, float *overlap)
+void tldOverlapOne(const WindowGrid *windows, int index, const int *indices, int numIndices, float *overlap)
 {
+    int bb1[TLD_WINDOW_SIZE];
+    int bb2[TLD_WINDOW_SIZE];
+    windows->window(index, bb1);
 
-    for(size_t i = 0; i < indices->size(); i++)
+    for(int i = 0; i < numIndices; i++)
     {
-
-        overlap[i] = tldBBOverlap(&windows[TLD_WINDOW_SIZE * index], &windows[TLD_WINDOW_SIZE * indices->at(i)]);
+        windows->window(indices[i], bb2);
+        overlap[i] = tldBBOverlap(bb1, bb2);
     }
 
 }
@@ -205,7 +209,7 @@ Rect *tldCopyRect(Rect *r)
     return r2;
 }
 
-void tldOverlapRect(int *windows, int numWindows, Rect *boundary, float *overlap)
+void tldOverlapRect(const WindowGrid *windows, Rect *boundary, float *overlap)
 {
     int bb[4];
     bb[0] = boundary->x;
@@ -213,18 +217,94 @@ void tldOverlapRect(int *windows, int numWindows, Rect *boundary, float *overlap
     bb[2] = boundary->width;
     bb[3] = boundary->height;
 
-    tldOverlap(windows, numWindows, bb, overlap);
+    tldOverlap(windows, bb, overlap);
+}
+
+//Largest a with a * d <= n, for d > 0
+static int floorDiv(int n, int d)
+{
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
 }
 
-void tldOverlap(int *windows, int numWindows, int *boundary, float *overlap)
+/* Appends the windows whose overlap with boundary is at least minOverlap, and
+ * their overlap, in ascending order of the window index. An overlap of t needs
+ * an intersection of at least t * (A1 + A2) / (1 + t) pixels, so per scale
+ * only the columns and rows where the intersection can be that wide and high
+ * are visited. minOverlap must be greater than 0.
+ */
+void tldOverlapping(const WindowGrid *windows, Rect *boundary, float minOverlap, vector<pair<int, float> > *result)
 {
+    int bb[4];
+    tldRectToArray<int>(*boundary, bb);
+
+    int window[TLD_WINDOW_SIZE];
 
-    for(int i = 0; i < numWindows; i++)
+    for(size_t s = 0; s < windows->scales.size(); s++)
     {
+        const WindowScale &scale = windows->scales[s];
+        int minWidth = min(scale.width, bb[2]);
+        int minHeight = min(scale.height, bb[3]);
+
+        if(minWidth <= 0 || minHeight <= 0) continue;
+
+        float minIntersection = minOverlap * (scale.width * scale.height + bb[2] * bb[3]) / (1 + minOverlap);
+
+        //Rounded down, so that no window is missed; the exact overlap decides
+        int colInt = (int) floor(minIntersection / minHeight);
+        int rowInt = (int) floor(minIntersection / minWidth);
+
+        if(colInt > minWidth || rowInt > minHeight) continue;
+
+        //x + w - bx >= colInt and bx + bw - x >= colInt
+        int colBegin = max(0, -floorDiv(windows->originX - (bb[0] + colInt - scale.width), scale.stepX));
+        int colEnd = min(scale.cols, floorDiv(bb[0] + bb[2] - colInt - windows->originX, scale.stepX) + 1);
+        int rowBegin = max(0, -floorDiv(windows->originY - (bb[1] + rowInt - scale.height), scale.stepY));
+        int rowEnd = min(scale.rows, floorDiv(bb[1] + bb[3] - rowInt - windows->originY, scale.stepY) + 1);
+
+        window[2] = scale.width;
+        window[3] = scale.height;
 
-        overlap[i] = tldBBOverlap(boundary, &windows[TLD_WINDOW_SIZE * i]);
+        for(int row = rowBegin; row < rowEnd; row++)
+        {
+            window[1] = windows->originY + row * scale.stepY;
+
+            for(int col = colBegin; col < colEnd; col++)
+            {
+                window[0] = windows->originX + col * scale.stepX;
+                float overlap = tldBBOverlap(bb, window);
+
+                if(overlap >= minOverlap)
+                {
+                    result->push_back(pair<int, float>(windows->windowIndex(s, col, row), overlap));
+                }
+            }
+        }
     }
+}
 
+//Scale by scale and row by row, so that no window index has to be mapped
+void tldOverlap(const WindowGrid *windows, int *boundary, float *overlap)
+{
+    int bb[TLD_WINDOW_SIZE];
+
+    for(size_t s = 0; s < windows->scales.size(); s++)
+    {
+        const WindowScale &scale = windows->scales[s];
+        float *out = overlap + scale.firstWindow;
+        bb[2] = scale.width;
+        bb[3] = scale.height;
+
+        for(int row = 0; row < scale.rows; row++)
+        {
+            bb[1] = windows->originY + row * scale.stepY;
+
+            for(int col = 0; col < scale.cols; col++)
+            {
+                bb[0] = windows->originX + col * scale.stepX;
+                *out++ = tldBBOverlap(boundary, bb);
+            }
+        }
+    }
 }
 
 
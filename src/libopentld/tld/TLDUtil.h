@@ -31,6 +31,8 @@
 
 #include <opencv/cv.h>
 
+#include "WindowGrid.h"
+
 namespace tld
 {
 
@@ -109,9 +111,10 @@ cv::Rect *tldCopyRect(cv::Rect *r);
 
 //TODO: Change function names
 float tldOverlapRectRect(cv::Rect r1, cv::Rect r2);
-void tldOverlapOne(int *windows, int numWindows, int index, std::vector<int> * indices, float *overlap);
-void tldOverlap(int *windows, int numWindows, int *boundary, float *overlap);
-void tldOverlapRect(int *windows, int numWindows, cv::Rect *boundary, float *overlap);
+void tldOverlapOne(const WindowGrid *windows, int index, const int *indices, int numIndices, float *overlap);
+void tldOverlap(const WindowGrid *windows, int *boundary, float *overlap);
+void tldOverlapRect(const WindowGrid *windows, cv::Rect *boundary, float *overlap);
+void tldOverlapping(const WindowGrid *windows, cv::Rect *boundary, float minOverlap, std::vector<std::pair<int, float> > *result);
 
 float tldCalcVariance(float *value, int n);
 
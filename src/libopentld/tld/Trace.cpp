@@ -0,0 +1,172 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * Trace.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "Trace.h"
+
+#ifdef TRACE_ENABLED
+
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+#include <pthread.h>
+#include <time.h>
+
+namespace tld
+{
+
+struct TraceEvent
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t duration;
+    int frame;
+};
+
+//Written by its thread only. When full, the oldest events are overwritten.
+struct TraceBuffer
+{
+    TraceEvent *events;
+    size_t capacity;
+    uint64_t numWritten;
+    int tid;
+};
+
+static pthread_mutex_t registryMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<TraceBuffer *> buffers;
+static __thread TraceBuffer *threadBuffer = NULL;
+
+static volatile int currentFrame = 0;
+//Nothing is recorded until tldTraceConfigure is called
+static int firstTracedFrame = 1;
+static int lastTracedFrame = 0;
+static size_t eventsPerBuffer = 1 << 16;
+static uint64_t origin = tldTraceNow();
+
+void tldTraceConfigure(int firstFrame, int lastFrame, int eventsPerThread)
+{
+    firstTracedFrame = firstFrame;
+    lastTracedFrame = (lastFrame > 0) ? lastFrame : INT_MAX;
+
+    if(eventsPerThread > 0)
+    {
+        eventsPerBuffer = eventsPerThread;
+    }
+}
+
+void tldTraceFrame(int frame)
+{
+    currentFrame = frame;
+}
+
+bool tldTraceActive()
+{
+    int frame = currentFrame;
+    return frame >= firstTracedFrame && frame <= lastTracedFrame;
+}
+
+//Nanoseconds
+uint64_t tldTraceNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static TraceBuffer *getThreadBuffer()
+{
+    if(threadBuffer == NULL)
+    {
+        TraceBuffer *buffer = new TraceBuffer();
+        buffer->capacity = eventsPerBuffer;
+        buffer->events = new TraceEvent[buffer->capacity];
+        buffer->numWritten = 0;
+
+        pthread_mutex_lock(&registryMutex);
+        buffer->tid = buffers.size() + 1;
+        buffers.push_back(buffer);
+        pthread_mutex_unlock(&registryMutex);
+
+        threadBuffer = buffer;
+    }
+
+    return threadBuffer;
+}
+
+void tldTraceRecord(const char *name, uint64_t begin, uint64_t end)
+{
+    TraceBuffer *buffer = getThreadBuffer();
+    TraceEvent *event = &buffer->events[buffer->numWritten % buffer->capacity];
+    event->name = name;
+    event->begin = begin;
+    event->duration = end - begin;
+    event->frame = currentFrame;
+    buffer->numWritten++;
+}
+
+//Should be called while no events are recorded
+bool tldTraceWrite(const char *path)
+{
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL)
+    {
+        printf("Error: Unable to write trace: %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+
+    pthread_mutex_lock(&registryMutex);
+
+    for(size_t i = 0; i < buffers.size(); i++)
+    {
+        TraceBuffer *buffer = buffers[i];
+
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                first ? "" : ",\n", buffer->tid, buffer->tid);
+        first = false;
+
+        uint64_t numEvents = (buffer->numWritten < buffer->capacity) ? buffer->numWritten : buffer->capacity;
+
+        for(uint64_t j = buffer->numWritten - numEvents; j < buffer->numWritten; j++)
+        {
+            const TraceEvent *event = &buffer->events[j % buffer->capacity];
+            fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"tld\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %d}}",
+                    event->name, (event->begin - origin) / 1000.0, event->duration / 1000.0, buffer->tid, event->frame);
+        }
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return true;
+}
+
+} /* namespace tld */
+
+#endif /* TRACE_ENABLED */
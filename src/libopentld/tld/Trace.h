@@ -0,0 +1,101 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * Trace.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/*
+ * Timeline of the pipeline in the Chrome trace-event format (chrome://tracing,
+ * Perfetto). Only compiled in with the CMake option TRACE_ENABLED; otherwise
+ * all macros expand to nothing.
+ * Every thread records complete events into its own ring buffer. Events are
+ * only recorded while the current frame is within the configured range.
+ */
+#ifdef TRACE_ENABLED
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace tld
+{
+
+//lastFrame <= 0 traces until the end, eventsPerThread <= 0 keeps the default
+void tldTraceConfigure(int firstFrame, int lastFrame, int eventsPerThread);
+void tldTraceFrame(int frame);
+bool tldTraceActive();
+uint64_t tldTraceNow();
+void tldTraceRecord(const char *name, uint64_t begin, uint64_t end);
+bool tldTraceWrite(const char *path);
+
+//Records the time between construction and stop() or destruction
+class TraceScope
+{
+    const char *name;
+    uint64_t begin;
+
+public:
+    TraceScope(const char *name) : name(NULL), begin(0)
+    {
+        if(tldTraceActive())
+        {
+            this->name = name;
+            begin = tldTraceNow();
+        }
+    }
+
+    ~TraceScope()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        if(name != NULL)
+        {
+            tldTraceRecord(name, begin, tldTraceNow());
+            name = NULL;
+        }
+    }
+};
+
+} /* namespace tld */
+
+#define TLD_TRACE_CONCAT_(a, b) a##b
+#define TLD_TRACE_CONCAT(a, b) TLD_TRACE_CONCAT_(a, b)
+#define TLD_TRACE_SCOPE(name) tld::TraceScope TLD_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TLD_TRACE_CONFIGURE(firstFrame, lastFrame, eventsPerThread) tld::tldTraceConfigure(firstFrame, lastFrame, eventsPerThread)
+#define TLD_TRACE_FRAME(frame) tld::tldTraceFrame(frame)
+#define TLD_TRACE_WRITE(path) tld::tldTraceWrite(path)
+
+#else
+
+#define TLD_TRACE_SCOPE(name)
+#define TLD_TRACE_CONFIGURE(firstFrame, lastFrame, eventsPerThread) ((void) 0)
+#define TLD_TRACE_FRAME(frame) ((void) 0)
+#define TLD_TRACE_WRITE(path) ((void) 0)
+
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H_ */
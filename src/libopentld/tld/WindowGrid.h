@@ -0,0 +1,155 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * WindowGrid.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef WINDOWGRID_H_
+#define WINDOWGRID_H_
+
+#include <vector>
+
+namespace tld
+{
+
+//Constants
+static const int TLD_WINDOW_SIZE = 5; //<x y w h scaleIndex>
+static const int TLD_WINDOW_OFFSET_SIZE = 6; //Four integral image corners, scale index, area
+
+//Windows of one scale, row by row
+struct WindowScale
+{
+    int firstWindow; //Index of the top left window
+    int cols;
+    int rows;
+    int width;
+    int height;
+    int stepX;
+    int stepY;
+};
+
+/**
+ * The detection windows, described per scale instead of per window. Windows
+ * are numbered scale by scale and row by row; the position and integral image
+ * offsets of a window are computed from its index, so memory only grows with
+ * the number of scales.
+ */
+class WindowGrid
+{
+public:
+    int originX; //Top left window of every scale
+    int originY;
+    int imgWidthStep;
+    int numWindows;
+    std::vector<WindowScale> scales;
+
+    WindowGrid() : originX(1), originY(1), imgWidthStep(0), numWindows(0)
+    {
+    }
+
+    void release()
+    {
+        scales.clear();
+        numWindows = 0;
+    }
+
+    //Appends the windows of width x height that fit into the area of
+    //areaWidth x areaHeight pixels at the origin
+    void addScale(int width, int height, int stepX, int stepY, int areaWidth, int areaHeight)
+    {
+        WindowScale scale;
+        scale.firstWindow = numWindows;
+        scale.cols = (areaWidth - width) / stepX + 1;
+        scale.rows = (areaHeight - height) / stepY + 1;
+        scale.width = width;
+        scale.height = height;
+        scale.stepX = stepX;
+        scale.stepY = stepY;
+
+        scales.push_back(scale);
+        numWindows += scale.cols * scale.rows;
+    }
+
+    int scaleIndex(int idx) const
+    {
+        int lo = 0;
+        int hi = scales.size() - 1;
+
+        while(lo < hi)
+        {
+            int mid = (lo + hi + 1) / 2;
+
+            if(scales[mid].firstWindow <= idx) lo = mid;
+            else hi = mid - 1;
+        }
+
+        return lo;
+    }
+
+    int windowIndex(int scale, int col, int row) const
+    {
+        return scales[scale].firstWindow + row * scales[scale].cols + col;
+    }
+
+    //Column and row of window idx within its scale
+    void position(int idx, int scale, int *col, int *row) const
+    {
+        const WindowScale &s = scales[scale];
+        int k = idx - s.firstWindow;
+        *row = k / s.cols;
+        *col = k - *row * s.cols;
+    }
+
+    //Writes <x y w h scaleIndex> of window idx
+    void window(int idx, int *bb) const
+    {
+        int scale = scaleIndex(idx);
+        int col, row;
+        position(idx, scale, &col, &row);
+
+        const WindowScale &s = scales[scale];
+        bb[0] = originX + col * s.stepX;
+        bb[1] = originY + row * s.stepY;
+        bb[2] = s.width;
+        bb[3] = s.height;
+        bb[4] = scale;
+    }
+
+    //Writes the offsets of the corners x1-1,y1-1; x1-1,y2; x2,y1-1; x2,y2 of
+    //window idx into an image of imgWidthStep, its scale index and its area
+    void offsets(int idx, int *off) const
+    {
+        int bb[TLD_WINDOW_SIZE];
+        window(idx, bb);
+
+        int base = (bb[1] - 1) * imgWidthStep + bb[0] - 1;
+        int down = bb[3] * imgWidthStep;
+        off[0] = base;
+        off[1] = base + down;
+        off[2] = base + bb[2];
+        off[3] = base + bb[2] + down;
+        off[4] = bb[4];
+        off[5] = bb[2] * bb[3];
+    }
+};
+
+} /* namespace tld */
+#endif /* WINDOWGRID_H_ */
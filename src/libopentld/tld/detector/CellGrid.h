@@ -0,0 +1,134 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * CellGrid.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef CELLGRID_H_
+#define CELLGRID_H_
+
+#include <algorithm>
+#include <vector>
+
+namespace tld
+{
+
+/**
+ * A grid of cellSize x cellSize cells over an image, in which cells are
+ * marked. After integrate(), the number of marked cells touched by a window
+ * takes four lookups, independent of the size of the window.
+ */
+class CellGrid
+{
+    //Marks, then their integral. (width + 1) * (height + 1) entries, row 0
+    //and column 0 stay 0.
+    std::vector<int> data;
+
+    int countMarked(const int *window, int *numCells) const
+    {
+        int x1 = window[0] / cellSize;
+        int y1 = window[1] / cellSize;
+        int x2 = std::min((window[0] + window[2] - 1) / cellSize, width - 1);
+        int y2 = std::min((window[1] + window[3] - 1) / cellSize, height - 1);
+        int stride = width + 1;
+
+        *numCells = (x2 - x1 + 1) * (y2 - y1 + 1);
+
+        return data[(y2 + 1) * stride + x2 + 1] - data[y1 * stride + x2 + 1]
+               - data[(y2 + 1) * stride + x1] + data[y1 * stride + x1];
+    }
+
+public:
+    int cellSize;
+    int width; //In cells
+    int height;
+
+    CellGrid(int cellSize) : cellSize(cellSize), width(0), height(0)
+    {
+    }
+
+    //Clears all marks of a grid over an image of imgWidth x imgHeight pixels
+    void reset(int imgWidth, int imgHeight)
+    {
+        width = (imgWidth + cellSize - 1) / cellSize;
+        height = (imgHeight + cellSize - 1) / cellSize;
+        data.assign((width + 1) * (height + 1), 0);
+    }
+
+    void mark(int cellX, int cellY)
+    {
+        data[(cellY + 1) * (width + 1) + cellX + 1] = 1;
+    }
+
+    //Marks all cells touched by the pixels x1..x2, y1..y2
+    void markPixels(int x1, int y1, int x2, int y2)
+    {
+        for(int y = y1 / cellSize; y <= y2 / cellSize; y++)
+        {
+            for(int x = x1 / cellSize; x <= x2 / cellSize; x++)
+            {
+                mark(x, y);
+            }
+        }
+    }
+
+    void integrate()
+    {
+        int stride = width + 1;
+
+        for(int y = 1; y <= height; y++)
+        {
+            int *row = &data[y * stride];
+            int *prev = row - stride;
+            int rowSum = 0;
+
+            for(int x = 1; x <= width; x++)
+            {
+                rowSum += row[x];
+                row[x] = prev[x] + rowSum;
+            }
+        }
+    }
+
+    //After integrate
+    bool marked(int cellX, int cellY) const
+    {
+        int stride = width + 1;
+        return data[(cellY + 1) * stride + cellX + 1] - data[cellY * stride + cellX + 1]
+               - data[(cellY + 1) * stride + cellX] + data[cellY * stride + cellX] != 0;
+    }
+
+    //window is <x y w h>, inside the image
+    bool allMarked(const int *window) const
+    {
+        int numCells;
+        return countMarked(window, &numCells) == numCells;
+    }
+
+    bool noneMarked(const int *window) const
+    {
+        int numCells;
+        return countMarked(window, &numCells) == 0;
+    }
+};
+
+} /* namespace tld */
+#endif /* CELLGRID_H_ */
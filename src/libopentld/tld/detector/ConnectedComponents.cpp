@@ -0,0 +1,181 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ConnectedComponents.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ConnectedComponents.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+
+namespace tld
+{
+
+//Returns the first position from x on that is not foreground (if foreground
+//is set) or not background. Checks 16 pixels at a time where possible.
+static int scanRow(const uchar *row, int x, int width, bool foreground)
+{
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    while(x + 16 <= width)
+    {
+        int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(row + x)), zero));
+        int stops = foreground ? zeros : (~zeros & 0xFFFF);
+
+        if(stops != 0)
+        {
+            return x + __builtin_ctz(stops);
+        }
+
+        x += 16;
+    }
+
+#endif
+
+    while(x < width && (row[x] != 0) == foreground)
+    {
+        x++;
+    }
+
+    return x;
+}
+
+int ConnectedComponents::find(int run)
+{
+    while(runs[run].parent != run)
+    {
+        runs[run].parent = runs[runs[run].parent].parent;
+        run = runs[run].parent;
+    }
+
+    return run;
+}
+
+//The root is always the first run of a component, so that components are
+//numbered in the order of their first pixel
+void ConnectedComponents::unite(int run1, int run2)
+{
+    int root1 = find(run1);
+    int root2 = find(run2);
+
+    if(root1 < root2)
+    {
+        runs[root2].parent = root1;
+    }
+    else if(root2 < root1)
+    {
+        runs[root1].parent = root2;
+    }
+}
+
+void ConnectedComponents::label(const Mat &img, int minArea)
+{
+    runs.clear();
+    boxes.clear();
+    areas.clear();
+
+    int prevBegin = 0;
+    int prevEnd = 0;
+
+    for(int y = 0; y < img.rows; y++)
+    {
+        const uchar *row = img.ptr<uchar>(y);
+        int begin = runs.size();
+        int x = 0;
+
+        while(true)
+        {
+            x = scanRow(row, x, img.cols, false);
+
+            if(x >= img.cols) break;
+
+            Run run;
+            run.x1 = x;
+            run.x2 = x = scanRow(row, x, img.cols, true);
+            run.y = y;
+            run.parent = runs.size();
+            runs.push_back(run);
+        }
+
+        int end = runs.size();
+
+        //Runs of both rows are sorted by x. Two runs are 8-connected if the
+        //one in the previous row starts at most one pixel after the current
+        //one ends and vice versa.
+        int j = prevBegin;
+
+        for(int i = begin; i < end; i++)
+        {
+            while(j < prevEnd && runs[j].x2 < runs[i].x1)
+            {
+                j++;
+            }
+
+            for(int k = j; k < prevEnd && runs[k].x1 <= runs[i].x2; k++)
+            {
+                unite(i, k);
+            }
+        }
+
+        prevBegin = begin;
+        prevEnd = end;
+    }
+
+    int numRuns = runs.size();
+    componentOf.resize(numRuns);
+    extents.clear();
+
+    for(int i = 0; i < numRuns; i++)
+    {
+        const Run &run = runs[i];
+        int root = find(i);
+
+        if(root == i)
+        {
+            Extent extent = {run.x1, run.y, run.x2, run.y, 0};
+            componentOf[i] = extents.size();
+            extents.push_back(extent);
+        }
+
+        Extent &extent = extents[componentOf[root]];
+        extent.x1 = std::min(extent.x1, run.x1);
+        extent.x2 = std::max(extent.x2, run.x2);
+        extent.y2 = run.y;
+        extent.area += run.x2 - run.x1;
+    }
+
+    for(size_t i = 0; i < extents.size(); i++)
+    {
+        const Extent &extent = extents[i];
+
+        if(extent.area < minArea) continue;
+
+        boxes.push_back(Rect(extent.x1, extent.y1, extent.x2 - extent.x1, extent.y2 - extent.y1 + 1));
+        areas.push_back(extent.area);
+    }
+}
+
+} /* namespace tld */
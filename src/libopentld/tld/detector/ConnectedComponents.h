@@ -0,0 +1,81 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * ConnectedComponents.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef CONNECTEDCOMPONENTS_H_
+#define CONNECTEDCOMPONENTS_H_
+
+#include <vector>
+
+#include <opencv/cv.h>
+
+namespace tld
+{
+
+/**
+ * Finds the 8-connected components of the non-zero pixels of a binary
+ * image and yields their bounding boxes and areas. Every row is split into
+ * runs of foreground pixels, runs touching a run of the previous row are
+ * merged with union-find. Only bounding boxes and pixel counts are
+ * collected; contours are never traced. Working memory is kept between
+ * calls.
+ */
+class ConnectedComponents
+{
+    struct Run
+    {
+        int x1;
+        int x2; //Exclusive
+        int y;
+        int parent;
+    };
+
+    struct Extent
+    {
+        int x1;
+        int y1;
+        int x2;
+        int y2;
+        int area;
+    };
+
+    std::vector<Run> runs;
+    std::vector<int> componentOf;
+    std::vector<Extent> extents;
+
+    int find(int run);
+    void unite(int run1, int run2);
+
+public:
+    std::vector<cv::Rect> boxes; //Bounding boxes of the components, ordered by their first pixel
+    std::vector<int> areas; //Number of pixels of each component
+
+    /**
+     * Labels an 8 bit, single channel image. Components smaller than
+     * minArea pixels are dropped.
+     */
+    void label(const cv::Mat &img, int minArea);
+};
+
+} /* namespace tld */
+#endif /* CONNECTEDCOMPONENTS_H_ */
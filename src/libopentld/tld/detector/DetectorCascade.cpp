@@ -27,16 +27,22 @@
 #include "DetectorCascade.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "TLDUtil.h"
-#include "Timing.h"
+#include "Trace.h"
 
 using namespace cv;
 
 namespace tld
 {
 
-DetectorCascade::DetectorCascade()
+DetectorCascade::DetectorCascade() : changes(16)
 {
     objWidth = -1; //MUST be set before calling init
     objHeight = -1; //MUST be set before calling init
@@ -53,9 +59,18 @@ DetectorCascade::DetectorCascade()
     numTrees = 13;
     numFeatures = 10;
 
+    reuseUnchanged = false;
+    changeThreshold = 0;
+    coarseStep = 1;
+    hugePages = HUGE_PAGES_OFF;
+    coarseWindowsStep = 0;
+    resultsReusable = false;
+
     initialised = false;
+    metrics = NULL;
+    frameArena = NULL;
 
-    //foregroundDetector = new ForegroundDetector();
+    foregroundDetector = new ForegroundDetector();
     varianceFilter = new VarianceFilter();
     ensembleClassifier = new EnsembleClassifier();
     nnClassifier = new NNClassifier();
@@ -68,7 +83,7 @@ DetectorCascade::~DetectorCascade()
 {
     release();
 
-    //delete foregroundDetector;
+    delete foregroundDetector;
     delete varianceFilter;
     delete ensembleClassifier;
     delete nnClassifier;
@@ -83,7 +98,6 @@ void DetectorCascade::init()
     }
 
     initWindowsAndScales();
-    initWindowOffsets();
 
     propagateMembers();
 
@@ -95,22 +109,25 @@ void DetectorCascade::init()
 //TODO: This is error-prone. Better give components a reference to DetectorCascade?
 void DetectorCascade::propagateMembers()
 {
+    detectionResult->hugePages = hugePages;
     detectionResult->init(numWindows, numTrees);
 
-    varianceFilter->windowOffsets = windowOffsets;
-    ensembleClassifier->windowOffsets = windowOffsets;
+    varianceFilter->windowGrid = &windowGrid;
+    varianceFilter->hugePages = hugePages;
+    ensembleClassifier->windowGrid = &windowGrid;
     ensembleClassifier->imgWidthStep = imgWidthStep;
     ensembleClassifier->numScales = numScales;
     ensembleClassifier->scales = scales;
     ensembleClassifier->numFeatures = numFeatures;
     ensembleClassifier->numTrees = numTrees;
-    nnClassifier->windows = windows;
-    clustering->windows = windows;
-    clustering->numWindows = numWindows;
+    nnClassifier->windowGrid = &windowGrid;
+    clustering->windowGrid = &windowGrid;
+    clustering->frameArena = frameArena;
 
-    //foregroundDetector->minBlobSize = minSize * minSize;
+    foregroundDetector->minBlobSize = minSize * minSize;
+    foregroundDetector->windowGrid = &windowGrid;
 
-    //foregroundDetector->detectionResult = detectionResult;
+    foregroundDetector->detectionResult = detectionResult;
     varianceFilter->detectionResult = detectionResult;
     ensembleClassifier->detectionResult = detectionResult;
     nnClassifier->detectionResult = detectionResult;
@@ -125,8 +142,12 @@ void DetectorCascade::release()
     }
 
     initialised = false;
+    resultsReusable = false;
+    previousImg.release();
+    coarseWindows.clear();
+    coarseWindowsStep = 0;
 
-    //foregroundDetector->release();
+    foregroundDetector->release();
     ensembleClassifier->release();
     nnClassifier->release();
 
@@ -137,10 +158,7 @@ void DetectorCascade::release()
 
     delete[] scales;
     scales = NULL;
-    delete[] windows;
-    windows = NULL;
-    delete[] windowOffsets;
-    windowOffsets = NULL;
+    windowGrid.release();
 
     objWidth = -1;
     objHeight = -1;
@@ -153,10 +171,8 @@ void DetectorCascade::cleanPreviousData()
     detectionResult->reset();
 }
 
-/* returns number of bounding boxes, bounding boxes, number of scales, scales
- * bounding boxes are stored in an array of size 5*numBBs using the format <x y w h scaleIndex>
- * scales are stored using the format <w h>
- *
+/* Lays out the windows of every scale on a grid (see WindowGrid) and returns
+ * the number of scales and the scales in the format <w h>
  */
 void DetectorCascade::initWindowsAndScales()
 {
@@ -166,11 +182,12 @@ void DetectorCascade::initWindowsAndScales()
     int scanAreaW = imgWidth - 1;
     int scanAreaH = imgHeight - 1;
 
-    int windowIndex = 0;
-
     scales = new Size[maxScale - minScale + 1];
 
-    numWindows = 0;
+    windowGrid.release();
+    windowGrid.originX = scanAreaX;
+    windowGrid.originY = scanAreaY;
+    windowGrid.imgWidthStep = imgWidthStep;
 
     int scaleIndex = 0;
 
@@ -199,70 +216,323 @@ void DetectorCascade::initWindowsAndScales()
 
         scaleIndex++;
 
-        numWindows += floor((float)(scanAreaW - w + ssw) / ssw) * floor((float)(scanAreaH - h + ssh) / ssh);
+        windowGrid.addScale(w, h, ssw, ssh, scanAreaW, scanAreaH);
     }
 
     numScales = scaleIndex;
+    numWindows = windowGrid.numWindows;
+    coarseWindowsStep = 0;
+}
 
-    windows = new int[TLD_WINDOW_SIZE * numWindows];
+bool DetectorCascade::unchanged(int windowIdx) const
+{
+    int bb[TLD_WINDOW_SIZE];
+    windowGrid.window(windowIdx, bb);
 
-    for(scaleIndex = 0; scaleIndex < numScales; scaleIndex++)
-    {
-        int w = scales[scaleIndex].width;
-        int h = scales[scaleIndex].height;
+    return changes.noneMarked(bb);
+}
 
-        int ssw, ssh;
+void DetectorCascade::invalidateResults()
+{
+    resultsReusable = false;
+}
 
-        if(useShift)
+//Windows left out by the coarse grid or outside the foreground still hold the
+//features of an older frame. Learning must not use those.
+void DetectorCascade::updateFeatureVectors(const std::vector<int> &windowIndices)
+{
+    EnsembleClassifier * _ensembleClassifier = dynamic_cast<EnsembleClassifier *>(ensembleClassifier);
+    const std::vector<int> *varianceIndices = detectionResult->varianceIndices;
+
+    for(size_t k = 0; k < windowIndices.size(); k++)
+    {
+        int i = windowIndices[k];
+
+        //Scanned windows either passed the variance filter or were rejected by it
+        if(detectionResult->windowStages[i] == WINDOW_UNKNOWN
+                && !std::binary_search(varianceIndices->begin(), varianceIndices->end(), i))
         {
-            ssw = max<float>(1, w * shift);
-            ssh = max<float>(1, h * shift);
+            _ensembleClassifier->calcFeatureVector(i, detectionResult->featureVectors + numTrees * i);
         }
-        else
+    }
+}
+
+//Marks the blocks of img that differ from the reference image by more than
+//changeThreshold and updates the reference. Returns false if there are no
+//results to reuse.
+//Only changed blocks are copied into the reference. Unchanged blocks keep the
+//pixels their reused outcomes were computed from, so a slow drift is measured
+//against those and not only against the previous frame.
+bool DetectorCascade::findChanges(const Mat &img)
+{
+    bool comparable = resultsReusable && previousImg.rows == img.rows && previousImg.cols == img.cols;
+
+    if(comparable)
+    {
+        int threshold = max(0, min(changeThreshold, 255));
+        int blockSize = changes.cellSize;
+        changes.reset(img.cols, img.rows);
+
+        for(int y = 0; y < img.rows; y++)
         {
-            ssw = 1;
-            ssh = 1;
+            const unsigned char *row = img.ptr<unsigned char>(y);
+            const unsigned char *prevRow = previousImg.ptr<unsigned char>(y);
+            int x = 0;
+
+#ifdef __SSE2__
+            //One vector per block and row if blocks are 16 pixels wide
+            const __m128i thresh = _mm_set1_epi8((char) threshold);
+            const __m128i zero = _mm_setzero_si128();
+
+            for(; blockSize == 16 && x + 16 <= img.cols; x += 16)
+            {
+                __m128i a = _mm_loadu_si128((const __m128i *)(row + x));
+                __m128i b = _mm_loadu_si128((const __m128i *)(prevRow + x));
+                __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+
+                if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(diff, thresh), zero)) != 0xFFFF)
+                {
+                    changes.mark(x / blockSize, y / blockSize);
+                }
+            }
+
+#endif
+
+            for(; x < img.cols; x++)
+            {
+                if(abs(row[x] - prevRow[x]) > threshold)
+                {
+                    changes.mark(x / blockSize, y / blockSize);
+                }
+            }
         }
 
-        for(int y = scanAreaY; y + h <= scanAreaY + scanAreaH; y += ssh)
+        changes.integrate();
+
+        for(int by = 0; by < changes.height; by++)
         {
-            for(int x = scanAreaX; x + w <= scanAreaX + scanAreaW; x += ssw)
+            int yEnd = min((by + 1) * blockSize, img.rows);
+
+            for(int bx = 0; bx < changes.width; bx++)
             {
-                int *bb = &windows[TLD_WINDOW_SIZE * windowIndex];
-                tldCopyBoundaryToArray<int>(x, y, w, h, bb);
-                bb[4] = scaleIndex;
+                if(!changes.marked(bx, by)) continue;
 
-                windowIndex++;
+                int x = bx * blockSize;
+                int width = min(blockSize, img.cols - x);
+
+                for(int y = by * blockSize; y < yEnd; y++)
+                {
+                    memcpy(previousImg.ptr<unsigned char>(y) + x, img.ptr<unsigned char>(y) + x, width);
+                }
             }
         }
+    }
+    else
+    {
+        img.copyTo(previousImg);
+    }
 
+    resultsReusable = false; //Until this detection is complete
+
+    return comparable;
+}
+
+//Collects the indices of the windows whose flag is set. Keeps the order of
+//indices, so the result does not depend on the scheduling of the stage.
+static void collectPassed(const char *flags, int n, const std::vector<int> *indices, std::vector<int> *passed)
+{
+    passed->clear();
+
+    for(int k = 0; k < n; k++)
+    {
+        if(flags[k])
+        {
+            passed->push_back((indices != NULL) ? (*indices)[k] : k);
+        }
     }
+}
 
-    assert(windowIndex == numWindows);
+//Merges the ascending indices of more into the ascending indices
+static void mergeIndices(std::vector<int> *indices, const std::vector<int> &more, std::vector<int> *scratch)
+{
+    scratch->resize(indices->size() + more.size());
+    std::merge(indices->begin(), indices->end(), more.begin(), more.end(), scratch->begin());
+    indices->swap(*scratch);
 }
 
-//Creates offsets that can be added to bounding boxes
-//offsets are contained in the form delta11, delta12,... (combined index of dw and dh)
-//Order: scale->tree->feature
-void DetectorCascade::initWindowOffsets()
+//Selects the windows on every coarseStep-th row and column of every scale
+void DetectorCascade::selectCoarseWindows()
 {
+    if(coarseWindowsStep == coarseStep) return;
 
-    windowOffsets = new int[TLD_WINDOW_OFFSET_SIZE * numWindows];
-    int *off = windowOffsets;
+    coarseWindows.clear();
+
+    for(size_t s = 0; s < windowGrid.scales.size(); s++)
+    {
+        const WindowScale &scale = windowGrid.scales[s];
+
+        for(int row = 0; row < scale.rows; row += coarseStep)
+        {
+            for(int col = 0; col < scale.cols; col += coarseStep)
+            {
+                coarseWindows.push_back(windowGrid.windowIndex(s, col, row));
+            }
+        }
+    }
+
+    coarseWindowsStep = coarseStep;
+}
+
+//Selects the windows of the same scale that lie less than coarseStep rows and
+//columns away from a coarse window that passed. Coarse windows are left out,
+//they have been scanned already.
+void DetectorCascade::selectFineWindows(const std::vector<int> *coarsePassed)
+{
+    fineWindows.clear();
+
+    for(size_t k = 0; k < coarsePassed->size(); k++)
+    {
+        int i = (*coarsePassed)[k];
+        int s = windowGrid.scaleIndex(i);
+        const WindowScale &scale = windowGrid.scales[s];
+        int col, row;
+        windowGrid.position(i, s, &col, &row);
+
+        int rowBegin = max(0, row - coarseStep + 1);
+        int rowEnd = min(scale.rows, row + coarseStep);
+        int colBegin = max(0, col - coarseStep + 1);
+        int colEnd = min(scale.cols, col + coarseStep);
+
+        for(int r = rowBegin; r < rowEnd; r++)
+        {
+            for(int c = colBegin; c < colEnd; c++)
+            {
+                if(r % coarseStep == 0 && c % coarseStep == 0) continue;
+
+                fineWindows.push_back(windowGrid.windowIndex(s, c, r));
+            }
+        }
+    }
+
+    //Neighbourhoods of adjacent coarse windows overlap
+    std::sort(fineWindows.begin(), fineWindows.end());
+    fineWindows.erase(std::unique(fineWindows.begin(), fineWindows.end()), fineWindows.end());
+}
 
-    int windowSize = TLD_WINDOW_SIZE;
+//Windows that were not scanned have no outcome in this frame. Their posterior
+//is cleared for learning and their stage must not be reused.
+void DetectorCascade::resetUnscanned()
+{
+    size_t c = 0;
+    size_t f = 0;
 
     for(int i = 0; i < numWindows; i++)
     {
+        if(c < coarseWindows.size() && coarseWindows[c] == i)
+        {
+            c++;
+        }
+        else if(f < fineWindows.size() && fineWindows[f] == i)
+        {
+            f++;
+        }
+        else
+        {
+            detectionResult->posteriors[i] = 0;
+            detectionResult->windowStages[i] = WINDOW_UNKNOWN;
+        }
+    }
+}
+
+//Runs the variance stage on the candidates, or on all windows if candidates is
+//NULL. Returns the number of windows whose outcome was reused.
+int DetectorCascade::filterVariance(const std::vector<int> *candidates, bool reuse, std::vector<int> *passed)
+{
+    VarianceFilter * _varianceFilter = dynamic_cast<VarianceFilter *>(varianceFilter);
+
+    //Windows in unchanged blocks take their outcome from the last detection.
+    //Their stage stays set; the stages of all other windows are recomputed.
+    char *flags = detectionResult->windowFlags;
+    char *stages = detectionResult->windowStages;
+    int numCandidates = (candidates != NULL) ? candidates->size() : numWindows;
+    int numReused = 0;
+
+    MetricsTimer varianceTimer(metrics, STAGE_VARIANCE);
+    #pragma omp parallel
+    {
+        TLD_TRACE_SCOPE("variance chunk");
+        MetricsWorker worker(metrics, STAGE_VARIANCE);
+        #pragma omp for nowait reduction(+:numReused)
+
+        for(int k = 0; k < numCandidates; k++)
+        {
+            int i = (candidates != NULL) ? (*candidates)[k] : k;
+
+            //Windows outside the foreground are rejected before their variance is calculated
+            if(!foregroundDetector->filter(i))
+            {
+                flags[k] = 0;
+                stages[i] = WINDOW_UNKNOWN;
+            }
+            else if(reuse && stages[i] != WINDOW_UNKNOWN && unchanged(i))
+            {
+                flags[k] = stages[i] != WINDOW_VARIANCE_REJECTED;
+                numReused++;
+            }
+            else
+            {
+                flags[k] = _varianceFilter->filter(i);
+                stages[i] = flags[k] ? WINDOW_UNKNOWN : WINDOW_VARIANCE_REJECTED;
+            }
 
-        int *window = windows + windowSize * i;
-        *off++ = sub2idx(window[0] - 1, window[1] - 1, imgWidthStep); // x1-1,y1-1
-        *off++ = sub2idx(window[0] - 1, window[1] + window[3] - 1, imgWidthStep); // x1-1,y2
-        *off++ = sub2idx(window[0] + window[2] - 1, window[1] - 1, imgWidthStep); // x2,y1-1
-        *off++ = sub2idx(window[0] + window[2] - 1, window[1] + window[3] - 1, imgWidthStep); // x2,y2
-        *off++ = window[4] * 2 * numFeatures * numTrees; // pointer to features for this scale
-        *off++ = window[2] * window[3]; //Area of bounding box
+            if(!flags[k])
+            {
+                detectionResult->posteriors[i] = 0;
+            }
+        }
     }
+
+    collectPassed(flags, numCandidates, candidates, passed);
+
+    return numReused;
+}
+
+void DetectorCascade::filterEnsemble(const std::vector<int> *candidates, std::vector<int> *passed)
+{
+    EnsembleClassifier * _ensembleClassifier = dynamic_cast<EnsembleClassifier *>(ensembleClassifier);
+
+    char *flags = detectionResult->windowFlags;
+    char *stages = detectionResult->windowStages;
+    int numCandidates = candidates->size();
+
+    MetricsTimer ensembleTimer(metrics, STAGE_ENSEMBLE);
+    #pragma omp parallel
+    {
+        TLD_TRACE_SCOPE("ensemble chunk");
+        MetricsWorker worker(metrics, STAGE_ENSEMBLE);
+        #pragma omp for nowait
+
+        for(int k = 0; k < numCandidates; k++)
+        {
+            int i = (*candidates)[k];
+
+            if(stages[i] != WINDOW_UNKNOWN)
+            {
+                flags[k] = stages[i] != WINDOW_ENSEMBLE_REJECTED;
+            }
+            else
+            {
+                flags[k] = _ensembleClassifier->filter(i);
+
+                if(!flags[k])
+                {
+                    stages[i] = WINDOW_ENSEMBLE_REJECTED;
+                }
+            }
+        }
+    }
+
+    collectPassed(flags, numCandidates, candidates, passed);
 }
 
 void DetectorCascade::detect(const Mat &img)
@@ -280,77 +550,94 @@ void DetectorCascade::detect(const Mat &img)
         return;
     }
 
-    tick_t procInit, procFinal;
     //Prepare components
-    //foregroundDetector->nextIteration(img); //Calculates foreground (DISABLED)
+    MetricsTimer integralTimer(metrics, STAGE_INTEGRAL);
+    foregroundDetector->nextIteration(img); //Calculates foreground and its occupancy grid
     _varianceFilter->nextIteration(img); //Calculates integral images
     _ensembleClassifier->nextIteration(img);
-    getCPUTick(&procInit);
+    integralTimer.stop();
 
-    int j = 0, k = 0;
-    #pragma omp parallel for
+    //Every stage runs on the survivors of the previous one. Workers only write
+    //per-window results; the lists of survivors are collected serially.
+    char *flags = detectionResult->windowFlags;
+    char *stages = detectionResult->windowStages;
+    std::vector<int> *varianceIndices = detectionResult->varianceIndices;
+    std::vector<int> *ensembleIndices = detectionResult->ensembleIndices;
 
-    for(int i = 0; i < numWindows; i++)
-    {        
-        /*
-         * Foreground detection disabled
-         *
-        int *window = &windows[TLD_WINDOW_SIZE * i];
+    bool reuse = reuseUnchanged && findChanges(img);
+    int numReused = 0;
+    int numScanned = numWindows;
 
-        if(foregroundDetector->isActive())
-        {
-            bool isInside = false;
+    if(coarseStep > 1)
+    {
+        //The coarse grid goes through variance and ensemble first. Only the
+        //neighbourhoods of its survivors are scanned at full density.
+        selectCoarseWindows();
+        numReused += filterVariance(&coarseWindows, reuse, varianceIndices);
+        filterEnsemble(varianceIndices, ensembleIndices);
 
-            for(size_t j = 0; j < detectionResult->fgList->size(); j++)
-            {
+        selectFineWindows(ensembleIndices);
+        numReused += filterVariance(&fineWindows, reuse, &fineVarianceIndices);
+        filterEnsemble(&fineVarianceIndices, &fineEnsembleIndices);
 
-                int bgBox[4];
-                tldRectToArray(detectionResult->fgList->at(j), bgBox);
+        mergeIndices(varianceIndices, fineVarianceIndices, &mergedIndices);
+        mergeIndices(ensembleIndices, fineEnsembleIndices, &mergedIndices);
 
-                if(tldIsInside(window, bgBox))  //TODO: This is inefficient and should be replaced by a quadtree
-                {
-                    isInside = true;
-                }
-            }
+        resetUnscanned();
+        numScanned = coarseWindows.size() + fineWindows.size();
+    }
+    else
+    {
+        numReused = filterVariance(NULL, reuse, varianceIndices);
+        filterEnsemble(varianceIndices, ensembleIndices);
+    }
 
-            if(!isInside)
-            {
-                detectionResult->posteriors[i] = 0;
-                continue;
-            }
-        }
-        */
+    int numVariancePassed = varianceIndices->size();
 
-        if(!_varianceFilter->filter(i))
-        {
-            detectionResult->posteriors[i] = 0;
-            continue;
-        }
-        j++;
+    MetricsTimer nnTimer(metrics, STAGE_NN);
+    int numEnsemblePassed = ensembleIndices->size();
+    #pragma omp parallel
+    {
+        TLD_TRACE_SCOPE("nn chunk");
+        MetricsWorker worker(metrics, STAGE_NN);
+        #pragma omp for nowait
 
-        if(!_ensembleClassifier->filter(i))
+        for(int k = 0; k < numEnsemblePassed; k++)
         {
-            continue;
-        }
-        k++;
+            int i = (*ensembleIndices)[k];
 
-        if(!_nnClassifier->filter(img, i))
-        {
-            continue;
+            if(stages[i] != WINDOW_UNKNOWN)
+            {
+                flags[k] = stages[i] == WINDOW_CONFIDENT;
+            }
+            else
+            {
+                flags[k] = _nnClassifier->filter(img, i);
+                stages[i] = flags[k] ? WINDOW_CONFIDENT : WINDOW_NN_REJECTED;
+            }
         }
-
-        detectionResult->confidentIndices->push_back(i);
-
-
     }
-    std::cout << numWindows << " - " << j << " - " << k << " ";
-    getCPUTick(&procFinal);
-    PRINT_TIMING("ClsfyTime", procInit, procFinal, ", ");
+
+    collectPassed(flags, numEnsemblePassed, ensembleIndices, detectionResult->confidentIndices);
+    nnTimer.stop();
 
     //Cluster
+    MetricsTimer clusteringTimer(metrics, STAGE_CLUSTERING);
     clustering->clusterConfidentIndices();
+    clusteringTimer.stop();
+
+    if(metrics != NULL)
+    {
+        metrics->addCount(COUNT_WINDOWS, numScanned);
+        metrics->addCount(COUNT_VARIANCE_PASSED, numVariancePassed);
+        metrics->addCount(COUNT_ENSEMBLE_PASSED, numEnsemblePassed);
+        metrics->addCount(COUNT_NN_PASSED, detectionResult->confidentIndices->size());
+        metrics->addCount(COUNT_CLUSTERS, detectionResult->numClusters);
+        metrics->addCount(COUNT_REUSED, numReused);
+    }
 
     detectionResult->containsValidData = true;
+    resultsReusable = reuseUnchanged;
 }
 
 } /* namespace tld */
@@ -29,9 +29,12 @@
 #ifndef DETECTORCASCADE_H_
 #define DETECTORCASCADE_H_
 
+#include <vector>
+
 #include "IDetectorCascade.h"
+#include "CellGrid.h"
 #include "DetectionResult.h"
-//#include "ForegroundDetector.h"
+#include "ForegroundDetector.h"
 #include "VarianceFilter.h"
 #include "EnsembleClassifier.h"
 #include "Clustering.h"
@@ -43,18 +46,38 @@ namespace tld
 
 class DetectorCascade : public IDetectorCascade
 {
+    cv::Mat previousImg; //Per block, the pixels the stored outcomes were computed from
+    CellGrid changes; //Blocks of the current image that differ from previousImg
+    bool resultsReusable; //Set if windowStages and the per-window results belong to previousImg and the current model
+
+    std::vector<int> coarseWindows; //Windows on every coarseStep-th row and column of their scale
+    int coarseWindowsStep; //The coarseStep coarseWindows was selected for
+    std::vector<int> fineWindows; //Neighbours of coarse windows that passed the ensemble stage
+    std::vector<int> fineVarianceIndices;
+    std::vector<int> fineEnsembleIndices;
+    std::vector<int> mergedIndices;
+
+    bool findChanges(const cv::Mat &img);
+    bool unchanged(int windowIdx) const;
+    void selectCoarseWindows();
+    void selectFineWindows(const std::vector<int> *coarsePassed);
+    void resetUnscanned();
+    int filterVariance(const std::vector<int> *candidates, bool reuse, std::vector<int> *passed);
+    void filterEnsemble(const std::vector<int> *candidates, std::vector<int> *passed);
+
 public:
 
     DetectorCascade();
     virtual ~DetectorCascade();
 
     virtual void init();
-    virtual void initWindowOffsets();
     virtual void initWindowsAndScales();
     virtual void propagateMembers();
     virtual void release();
     virtual void cleanPreviousData();
     virtual void detect(const cv::Mat &img);
+    virtual void invalidateResults();
+    virtual void updateFeatureVectors(const std::vector<int> &windowIndices);
 };
 
 } /* namespace tld */
@@ -49,6 +49,9 @@ EnsembleClassifier::EnsembleClassifier()
     posteriors = NULL;
     positives = NULL;
     negatives = NULL;
+    sharedModel = false;
+    changedLeaves = NULL;
+    numUpdates = 0;
     numTrees = 10;
     numFeatures = 13;
     enabled = true;
@@ -71,16 +74,21 @@ void EnsembleClassifier::init()
 
 void EnsembleClassifier::release()
 {
-    delete[] features;
+    if(!sharedModel)
+    {
+        delete[] features;
+        delete[] posteriors;
+        delete[] positives;
+        delete[] negatives;
+    }
+
+    sharedModel = false;
     features = NULL;
-    delete[] featureOffsets;
-    featureOffsets = NULL;
-    delete[] posteriors;
     posteriors = NULL;
-    delete[] positives;
     positives = NULL;
-    delete[] negatives;
     negatives = NULL;
+    delete[] featureOffsets;
+    featureOffsets = NULL;
 }
 
 /*
@@ -149,13 +157,20 @@ void EnsembleClassifier::nextIteration(const Mat &img)
     this->img = (const unsigned char *)img.data;
 }
 
-//Classical fern algorithm
 int EnsembleClassifier::calcFernFeature(int windowIdx, int treeIdx)
+{
+    int bbox[TLD_WINDOW_OFFSET_SIZE];
+    windowGrid->offsets(windowIdx, bbox);
+
+    return calcFernFeature(bbox, treeIdx);
+}
+
+//Classical fern algorithm
+int EnsembleClassifier::calcFernFeature(const int *bbox, int treeIdx)
 {
 
     int index = 0;
-    int *bbox = windowOffsets + windowIdx * TLD_WINDOW_OFFSET_SIZE;
-    int *off = featureOffsets + bbox[4] + treeIdx * 2 * numFeatures; //bbox[4] is pointer to features for the current scale
+    int *off = featureOffsets + (bbox[4] * numTrees + treeIdx) * 2 * numFeatures; //bbox[4] is the scale of the window
 
     for(int i = 0; i < numFeatures; i++)
     {
@@ -177,9 +192,12 @@ int EnsembleClassifier::calcFernFeature(int windowIdx, int treeIdx)
 
 void EnsembleClassifier::calcFeatureVector(int windowIdx, int *featureVector)
 {
+    int bbox[TLD_WINDOW_OFFSET_SIZE];
+    windowGrid->offsets(windowIdx, bbox);
+
     for(int i = 0; i < numTrees; i++)
     {
-        featureVector[i] = calcFernFeature(windowIdx, i);
+        featureVector[i] = calcFernFeature(bbox, i);
     }
 }
 
@@ -216,9 +234,15 @@ bool EnsembleClassifier::filter(int i)
 
 void EnsembleClassifier::updatePosterior(int treeIdx, int idx, int positive, int amount)
 {
+    numUpdates++;
     int arrayIndex = treeIdx * numIndices + idx;
     (positive) ? positives[arrayIndex] += amount : negatives[arrayIndex] += amount;
     posteriors[arrayIndex] = ((float) positives[arrayIndex]) / (positives[arrayIndex] + negatives[arrayIndex]) / 10.0;
+
+    if(changedLeaves != NULL)
+    {
+        changedLeaves->push_back(arrayIndex);
+    }
 }
 
 void EnsembleClassifier::updatePosteriors(int *featureVector, int positive, int amount)
@@ -247,5 +271,53 @@ void EnsembleClassifier::learn(int *boundary, int positive, int *featureVector)
 
 }
 
+//The confidences of all windows are calculated in parallel with the
+//posteriors from before the batch. A window is only classified again if a
+//window learned before it in this batch touched one of its leaves, so the
+//posteriors end up as if the windows were learned one after the other.
+void EnsembleClassifier::learn(const vector<int> &windowIndices, int positive)
+{
+    if(!enabled) return;
+
+    int numWindows = windowIndices.size();
+
+    if(numWindows == 0) return;
+
+    learnConfidences.resize(numWindows);
+
+    #pragma omp parallel for if(numWindows > 64)
+    for(int i = 0; i < numWindows; i++)
+    {
+        learnConfidences[i] = calcConfidence(detectionResult->featureVectors + numTrees * windowIndices[i]);
+    }
+
+    learnTouched.assign(numTrees * numIndices, 0);
+
+    for(int i = 0; i < numWindows; i++)
+    {
+        int *featureVector = detectionResult->featureVectors + numTrees * windowIndices[i];
+        float conf = learnConfidences[i];
+
+        for(int j = 0; j < numTrees; j++)
+        {
+            if(learnTouched[j * numIndices + featureVector[j]])
+            {
+                conf = calcConfidence(featureVector);
+                break;
+            }
+        }
+
+        //Update if positive patch and confidence < 0.5 or negative and conf > 0.5
+        if((positive && conf < 0.5) || (!positive && conf > 0.5))
+        {
+            updatePosteriors(featureVector, positive, 1);
+
+            for(int j = 0; j < numTrees; j++)
+            {
+                learnTouched[j * numIndices + featureVector[j]] = 1;
+            }
+        }
+    }
+}
 
 } /* namespace tld */
@@ -40,11 +40,17 @@ class EnsembleClassifier : public IEnsembleClassifier
 {
     const unsigned char *img;
 
+    //Scratch space of the batched learn
+    std::vector<float> learnConfidences;
+    std::vector<char> learnTouched;
+
+    void updatePosteriors(int *featureVector, int positive, int amount);
+public:
     float calcConfidence(int *featureVector);
     int calcFernFeature(int windowIdx, int treeIdx);
+    int calcFernFeature(const int *bbox, int treeIdx); //bbox as written by WindowGrid::offsets
     void calcFeatureVector(int windowIdx, int *featureVector);
-    void updatePosteriors(int *featureVector, int positive, int amount);
-public:
+
     EnsembleClassifier();
     virtual ~EnsembleClassifier();
     void init();
@@ -56,6 +62,7 @@ public:
     void classifyWindow(int windowIdx);
     void updatePosterior(int treeIdx, int idx, int positive, int amount);
     void learn(int *boundary, int positive, int *featureVector);
+    void learn(const std::vector<int> &windowIndices, int positive);
     bool filter(int i);
 };
 
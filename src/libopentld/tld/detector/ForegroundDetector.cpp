@@ -25,60 +25,186 @@
 
 #include "ForegroundDetector.h"
 
-#include "BlobResult.h"
+#include <cstdlib>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "IDetectorCascade.h"
 
 using namespace cv;
+using namespace std;
 
 namespace tld
 {
 
-ForegroundDetector::ForegroundDetector()
+ForegroundDetector::ForegroundDetector() : occupancy(8)
 {
+    gating = false;
+    numFrames = 0;
+    enabled = true;
+    adaptive = false;
+    adaptationShift = 6;
     fgThreshold = 16;
     minBlobSize = 0;
+    cellSize = 8;
+    windowGrid = NULL;
+    detectionResult = NULL;
 }
 
 ForegroundDetector::~ForegroundDetector()
 {
+    release();
 }
 
 void ForegroundDetector::release()
 {
+    gating = false;
 }
 
-void ForegroundDetector::nextIteration(const Mat &img)
+void tldUpdateAverageRow(const uchar *img, short *average, uchar *foreground, int width, int threshold, int shift, bool vectorized)
 {
-    if(bgImg.empty())
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thresh = _mm_set1_epi16(threshold);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+
+    for(; vectorized && x + 16 <= width; x += 16)
     {
-        return;
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(img + x));
+        __m128i pixels0 = _mm_unpacklo_epi8(pixels, zero);
+        __m128i pixels1 = _mm_unpackhi_epi8(pixels, zero);
+        __m128i average0 = _mm_loadu_si128((const __m128i *)(average + x));
+        __m128i average1 = _mm_loadu_si128((const __m128i *)(average + x + 8));
+
+        __m128i diff0 = _mm_sub_epi16(pixels0, _mm_srai_epi16(average0, 7));
+        __m128i diff1 = _mm_sub_epi16(pixels1, _mm_srai_epi16(average1, 7));
+        diff0 = _mm_max_epi16(diff0, _mm_sub_epi16(zero, diff0));
+        diff1 = _mm_max_epi16(diff1, _mm_sub_epi16(zero, diff1));
+        _mm_storeu_si128((__m128i *)(foreground + x), _mm_packs_epi16(_mm_cmpgt_epi16(diff0, thresh), _mm_cmpgt_epi16(diff1, thresh)));
+
+        average0 = _mm_add_epi16(average0, _mm_sra_epi16(_mm_sub_epi16(_mm_slli_epi16(pixels0, 7), average0), count));
+        average1 = _mm_add_epi16(average1, _mm_sra_epi16(_mm_sub_epi16(_mm_slli_epi16(pixels1, 7), average1), count));
+        _mm_storeu_si128((__m128i *)(average + x), average0);
+        _mm_storeu_si128((__m128i *)(average + x + 8), average1);
     }
 
-    Mat absImg = Mat(img.cols, img.rows, img.type());
-    Mat threshImg = Mat(img.cols, img.rows, img.type());
+#endif
 
-    absdiff(bgImg, img, absImg);
-    threshold(absImg, threshImg, fgThreshold, 255, CV_THRESH_BINARY);
+    for(; x < width; x++)
+    {
+        int diff = img[x] - (average[x] >> 7);
+        foreground[x] = (abs(diff) > threshold) ? 255 : 0;
+        average[x] += ((img[x] << 7) - average[x]) >> shift;
+    }
+}
 
-    IplImage im = (IplImage)threshImg;
-    CBlobResult blobs = CBlobResult(&im, NULL, 0);
+//Returns false while the average is still being built up
+bool ForegroundDetector::updateAverage(const Mat &img, Mat &foreground)
+{
+    int shift = min(max(adaptationShift, 0), 7);
 
-    blobs.Filter(blobs, B_EXCLUDE, CBlobGetArea(), B_LESS, minBlobSize);
+    if(average.rows != img.rows || average.cols != img.cols)
+    {
+        //A background image of the right size is used as the first average
+        const Mat &first = (bgImg.rows == img.rows && bgImg.cols == img.cols) ? bgImg : img;
+        numFrames = (&first == &bgImg) ? (1 << shift) : 0;
+        average.create(img.rows, img.cols, CV_16S);
+
+        for(int y = 0; y < img.rows; y++)
+        {
+            const uchar *src = first.ptr<uchar>(y);
+            short *dst = average.ptr<short>(y);
+
+            for(int x = 0; x < img.cols; x++)
+            {
+                dst[x] = src[x] << 7;
+            }
+        }
+    }
+
+    foreground.create(img.rows, img.cols, CV_8UC1);
+
+    for(int y = 0; y < img.rows; y++)
+    {
+        tldUpdateAverageRow(img.ptr<uchar>(y), average.ptr<short>(y), foreground.ptr<uchar>(y), img.cols, fgThreshold, shift, true);
+    }
+
+    numFrames++;
+
+    return numFrames > (1 << shift);
+}
+
+void ForegroundDetector::nextIteration(const Mat &img)
+{
+    gating = false;
+
+    if(!isActive())
+    {
+        return;
+    }
+
+    if(adaptive)
+    {
+        if(!updateAverage(img, threshImg))
+        {
+            detectionResult->fgList->clear();
+            return;
+        }
+    }
+    else
+    {
+        if(bgImg.cols != img.cols || bgImg.rows != img.rows)
+        {
+            printf("Error: Background image is %dx%d, frames are %dx%d\n", bgImg.cols, bgImg.rows, img.cols, img.rows);
+            bgImg.release();
+            return;
+        }
+
+        absdiff(bgImg, img, absImg);
+        threshold(absImg, threshImg, fgThreshold, 255, CV_THRESH_BINARY);
+    }
+
+    components.label(threshImg, minBlobSize);
 
     vector<Rect>* fgList = detectionResult->fgList;
-    fgList->clear();
+    fgList->assign(components.boxes.begin(), components.boxes.end());
+
+    occupancy.cellSize = cellSize;
+    occupancy.reset(img.cols, img.rows);
 
-    for(int i = 0; i < blobs.GetNumBlobs(); i++)
+    for(size_t i = 0; i < fgList->size(); i++)
     {
-        CBlob *blob = blobs.GetBlob(i);
-        CvRect rect = blob->GetBoundingBox();
-        fgList->push_back(rect);
+        const Rect &r = fgList->at(i);
+
+        if(r.width <= 0 || r.height <= 0) continue;
+
+        occupancy.markPixels(max(r.x, 0), max(r.y, 0), min(r.x + r.width - 1, img.cols - 1), min(r.y + r.height - 1, img.rows - 1));
     }
 
+    occupancy.integrate();
+
+    gating = true;
 }
 
 bool ForegroundDetector::isActive()
 {
-    return !bgImg.empty();
+    return enabled && (adaptive || !bgImg.empty());
+}
+
+//A window inside the bounding box of a blob only touches covered cells, so
+//such windows are never rejected
+bool ForegroundDetector::filter(int idx)
+{
+    if(!gating) return true;
+
+    int bb[TLD_WINDOW_SIZE];
+    windowGrid->window(idx, bb);
+
+    return occupancy.allMarked(bb);
 }
 
 } /* namespace tld */
@@ -31,17 +31,44 @@
 
 #include <opencv/cv.h>
 
+#include "CellGrid.h"
+#include "ConnectedComponents.h"
 #include "DetectionResult.h"
+#include "WindowGrid.h"
 
 namespace tld
 {
 
+/**
+ * Restricts detection to windows inside the foreground, i.e. inside the
+ * bounding box of a blob differing from the background. The background is
+ * either the static bgImg or, if adaptive is set, a running average of the
+ * frames that follows every frame by 2^-adaptationShift. The blobs are rasterized
+ * into a grid of cellSize x cellSize cells; a window is accepted if every
+ * cell it touches is covered by a blob, which takes four lookups in the
+ * integral of the grid.
+ */
 class ForegroundDetector
 {
+    CellGrid occupancy; //Cells covered by a blob
+    bool gating; //Set if the grid is valid for the current frame
+    cv::Mat average; //Running average, fixed point with 7 fractional bits
+    int numFrames; //Frames averaged so far
+    ConnectedComponents components;
+    cv::Mat absImg; //Buffers of nextIteration, kept between frames
+    cv::Mat threshImg;
+
+    bool updateAverage(const cv::Mat &img, cv::Mat &foreground);
+
 public:
+    bool enabled;
+    bool adaptive;
+    int adaptationShift; //0 to 7
     int fgThreshold;
     int minBlobSize;
+    int cellSize;
     cv::Mat bgImg;
+    const WindowGrid *windowGrid;
     DetectionResult *detectionResult;
 
     ForegroundDetector();
@@ -49,7 +76,16 @@ public:
     void release();
     void nextIteration(const cv::Mat &img);
     bool isActive();
+    bool filter(int idx);
 };
 
+/**
+ * Marks the pixels of a row differing from the average by more than
+ * threshold and moves the average towards the row by 2^-shift. The average
+ * has 7 fractional bits. Rows are processed with SSE2 where available,
+ * unless vectorized is false.
+ */
+void tldUpdateAverageRow(const uchar *img, short *average, uchar *foreground, int width, int threshold, int shift, bool vectorized);
+
 } /* namespace tld */
 #endif /* FOREGROUNDDETECTOR_H_ */
@@ -29,6 +29,8 @@
 
 #include <opencv/cv.h>
 
+#include "LargeAlloc.h"
+
 namespace tld
 {
 
@@ -41,14 +43,16 @@ public:
     int width;
     int height;
 
-    IntegralImage(cv::Size size)
+    IntegralImage(cv::Size size, int hugePages = HUGE_PAGES_OFF)
     {
-        data = new T[size.width * size.height];
+        width = size.width;
+        height = size.height;
+        data = tldAllocLargeArray<T>(width * height, hugePages);
     }
 
     virtual ~IntegralImage()
     {
-        delete[] data;
+        tldFreeLarge(data);
     }
 
     void calcIntImg(const cv::Mat &img, bool squared = false)
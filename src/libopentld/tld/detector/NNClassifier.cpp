@@ -25,6 +25,8 @@
 
 #include "NNClassifier.h"
 
+#include <algorithm>
+
 #include "DetectorCascade.h"
 #include "TLDUtil.h"
 
@@ -42,6 +44,11 @@ NNClassifier::NNClassifier()
     truePositives = new vector<NormalizedPatch>();
     falsePositives = new vector<NormalizedPatch>();
 
+    sharedFalsePositives = NULL;
+    sharedTruePositives = NULL;
+    numSharedFalsePositives = 0;
+    numSharedTruePositives = 0;
+
 }
 
 NNClassifier::~NNClassifier()
@@ -56,9 +63,14 @@ void NNClassifier::release()
 {
     falsePositives->clear();
     truePositives->clear();
+
+    sharedFalsePositives = NULL;
+    sharedTruePositives = NULL;
+    numSharedFalsePositives = 0;
+    numSharedTruePositives = 0;
 }
 
-float NNClassifier::ncc(float *f1, float *f2)
+float NNClassifier::ncc(const float *f1, const float *f2)
 {
     double corr = 0;
     double norm1 = 0;
@@ -78,51 +90,59 @@ float NNClassifier::ncc(float *f1, float *f2)
     return (corr / sqrt(norm1 * norm2) + 1) / 2.0;
 }
 
-float NNClassifier::classifyPatch(NormalizedPatch *patch)
+//Highest correlation of values with the positive or negative templates in [begin, end)
+float NNClassifier::maxCorrelation(const float *values, bool positive, int begin, int end)
 {
-    if(truePositives->empty())
-    {
-        return 0;
-    }
+    float ccorr_max = 0;
 
-    if(falsePositives->empty())
+    for(int i = begin; i < end; i++)
     {
-        return 1;
-    }
+        float ccorr = ncc(positive ? truePositive(i) : falsePositive(i), values);
 
-    float ccorr_max_p = 0;
-
-    //Compare patch to positive patches
-    for(size_t i = 0; i < truePositives->size(); i++)
-    {
-        float ccorr = ncc(truePositives->at(i).values, patch->values);
-
-        if(ccorr > ccorr_max_p)
+        if(ccorr > ccorr_max)
         {
-            ccorr_max_p = ccorr;
+            ccorr_max = ccorr;
         }
     }
 
-    float ccorr_max_n = 0;
+    return ccorr_max;
+}
 
-    //Compare patch to positive patches
-    for(size_t i = 0; i < falsePositives->size(); i++)
+float NNClassifier::relativeSimilarity(int numTrue, int numFalse, float ccorrMaxP, float ccorrMaxN)
+{
+    if(numTrue == 0)
     {
-        float ccorr = ncc(falsePositives->at(i).values, patch->values);
+        return 0;
+    }
 
-        if(ccorr > ccorr_max_n)
-        {
-            ccorr_max_n = ccorr;
-        }
+    if(numFalse == 0)
+    {
+        return 1;
     }
 
-    float dN = 1 - ccorr_max_n;
-    float dP = 1 - ccorr_max_p;
+    float dN = 1 - ccorrMaxN;
+    float dP = 1 - ccorrMaxP;
 
     float distance = dN / (dN + dP);
     return distance;
 }
 
+float NNClassifier::classifyPatch(NormalizedPatch *patch)
+{
+    int numTrue = numTruePositives();
+    int numFalse = numFalsePositives();
+
+    if(numTrue == 0 || numFalse == 0)
+    {
+        return relativeSimilarity(numTrue, numFalse, 0, 0);
+    }
+
+    float ccorr_max_p = maxCorrelation(patch->values, true, 0, numTrue);
+    float ccorr_max_n = maxCorrelation(patch->values, false, 0, numFalse);
+
+    return relativeSimilarity(numTrue, numFalse, ccorr_max_p, ccorr_max_n);
+}
+
 float NNClassifier::classifyBB(const Mat &img, Rect *bb)
 {
     NormalizedPatch patch;
@@ -136,7 +156,8 @@ float NNClassifier::classifyWindow(const Mat &img, int windowIdx)
 {
     NormalizedPatch patch;
 
-    int *bbox = &windows[TLD_WINDOW_SIZE * windowIdx];
+    int bbox[TLD_WINDOW_SIZE];
+    windowGrid->window(windowIdx, bbox);
     tldExtractNormalizedPatchBB(img, bbox, patch.values);
 
     return classifyPatch(&patch);
@@ -156,15 +177,35 @@ bool NNClassifier::filter(const Mat &img, int windowIdx)
     return true;
 }
 
-void NNClassifier::learn(vector<NormalizedPatch> patches)
+//All patches are first compared to the templates there are before learning,
+//in parallel. Patches are then added in order, each one compared only to the
+//templates added before it in this call, which gives the same templates as
+//classifying and adding them one after the other.
+void NNClassifier::learn(const vector<NormalizedPatch> &patches)
 {
     //TODO: Randomization might be a good idea here
-    for(size_t i = 0; i < patches.size(); i++)
+    int numPatches = patches.size();
+    int numTrue = numTruePositives();
+    int numFalse = numFalsePositives();
+
+    learnMaxP.resize(numPatches);
+    learnMaxN.resize(numPatches);
+
+    #pragma omp parallel for if(numPatches > 1)
+    for(int i = 0; i < numPatches; i++)
+    {
+        learnMaxP[i] = maxCorrelation(patches[i].values, true, 0, numTrue);
+        learnMaxN[i] = maxCorrelation(patches[i].values, false, 0, numFalse);
+    }
+
+    for(int i = 0; i < numPatches; i++)
     {
+        const NormalizedPatch &patch = patches[i];
 
-        NormalizedPatch patch = patches[i];
+        float ccorr_max_p = std::max(learnMaxP[i], maxCorrelation(patch.values, true, numTrue, numTruePositives()));
+        float ccorr_max_n = std::max(learnMaxN[i], maxCorrelation(patch.values, false, numFalse, numFalsePositives()));
 
-        float conf = classifyPatch(&patch);
+        float conf = relativeSimilarity(numTruePositives(), numFalsePositives(), ccorr_max_p, ccorr_max_n);
 
         if(patch.positive && conf <= thetaTP)
         {
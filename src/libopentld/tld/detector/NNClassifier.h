@@ -42,8 +42,15 @@ namespace tld
 
 class NNClassifier : public INNClassifier
 {
-    float ncc(float *f1, float *f2);
+    //Scratch space of learn
+    std::vector<float> learnMaxP;
+    std::vector<float> learnMaxN;
+
+    float maxCorrelation(const float *values, bool positive, int begin, int end);
+    static float relativeSimilarity(int numTrue, int numFalse, float ccorrMaxP, float ccorrMaxN);
 public:
+    float ncc(const float *f1, const float *f2);
+
     NNClassifier();
     virtual ~NNClassifier();
 
@@ -51,7 +58,7 @@ public:
     float classifyPatch(NormalizedPatch *patch);
     float classifyBB(const cv::Mat &img, cv::Rect *bb);
     float classifyWindow(const cv::Mat &img, int windowIdx);
-    void learn(std::vector<NormalizedPatch> patches);
+    void learn(const std::vector<NormalizedPatch> &patches);
     bool filter(const cv::Mat &img, int windowIdx);
 };
 
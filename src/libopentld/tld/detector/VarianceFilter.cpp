@@ -38,6 +38,7 @@ VarianceFilter::VarianceFilter()
 {
     enabled = true;
     minVar = 0;
+    hugePages = HUGE_PAGES_OFF;
     integralImg = NULL;
     integralImg_squared = NULL;
 }
@@ -73,12 +74,16 @@ void VarianceFilter::nextIteration(const Mat &img)
 {
     if(!enabled) return;
 
-    release();
+    //Every entry is overwritten, so the images are kept while the size does not change
+    if(integralImg == NULL || integralImg->width != img.cols || integralImg->height != img.rows)
+    {
+        release();
 
-    integralImg = new IntegralImage<int>(img.size());
-    integralImg->calcIntImg(img);
+        integralImg = new IntegralImage<int>(img.size(), hugePages);
+        integralImg_squared = new IntegralImage<long long>(img.size(), hugePages);
+    }
 
-    integralImg_squared = new IntegralImage<long long>(img.size());
+    integralImg->calcIntImg(img);
     integralImg_squared->calcIntImg(img, true);
 }
 
@@ -86,7 +91,9 @@ bool VarianceFilter::filter(int i)
 {
     if(!enabled) return true;
 
-    float bboxvar = calcVariance(windowOffsets + TLD_WINDOW_OFFSET_SIZE * i);
+    int off[TLD_WINDOW_OFFSET_SIZE];
+    windowGrid->offsets(i, off);
+    float bboxvar = calcVariance(off);
 
     detectionResult->variances[i] = bboxvar;
 
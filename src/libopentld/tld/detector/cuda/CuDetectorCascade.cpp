@@ -22,7 +22,6 @@
 #include <algorithm>
 
 #include "TLDUtil.h"
-#include "Timing.h"
 
 using namespace cv;
 
@@ -51,11 +50,18 @@ CuDetectorCascade::CuDetectorCascade()
     numTrees = 13;
     numFeatures = 10;
 
+    reuseUnchanged = false;
+    changeThreshold = 0;
+    coarseStep = 1;
+    hugePages = HUGE_PAGES_OFF;
+
     initialised = false;
+    metrics = NULL;
+    frameArena = NULL;
     windows_d = NULL;
     d_inWinIndices = NULL;
 
-    //foregroundDetector = new ForegroundDetector();
+    foregroundDetector = new ForegroundDetector();
     varianceFilter = new CuVarianceFilter();
     ensembleClassifier = new CuEnsembleClassifier();
     nnClassifier = new NNClassifier();
@@ -69,7 +75,7 @@ CuDetectorCascade::~CuDetectorCascade()
 {
     release();
 
-    //delete foregroundDetector;
+    delete foregroundDetector;
     delete varianceFilter;
     delete ensembleClassifier;
     delete nnClassifier;
@@ -84,7 +90,6 @@ void CuDetectorCascade::init()
     }
 
     initWindowsAndScales();
-    initWindowOffsets();
 
     propagateMembers();
 
@@ -96,23 +101,26 @@ void CuDetectorCascade::init()
 //TODO: This is error-prone. Better give components a reference to CuDetectorCascade?
 void CuDetectorCascade::propagateMembers()
 {
+    detectionResult->hugePages = hugePages;
     detectionResult->init(numWindows, numTrees);
 
-    varianceFilter->windowOffsets = windowOffsets;
-    ensembleClassifier->windowOffsets = windowOffsets;
+    varianceFilter->windowGrid = &windowGrid;
+    varianceFilter->hugePages = hugePages;
+    ensembleClassifier->windowGrid = &windowGrid;
     ensembleClassifier->imgWidthStep = imgWidthStep;
     ensembleClassifier->numScales = numScales;
     ensembleClassifier->scales = scales;
     ensembleClassifier->numFeatures = numFeatures;
     ensembleClassifier->numTrees = numTrees;
     dynamic_cast<CuEnsembleClassifier *>(ensembleClassifier)->numWindows = numWindows;
-    nnClassifier->windows = windows;
-    clustering->windows = windows;
-    clustering->numWindows = numWindows;
+    nnClassifier->windowGrid = &windowGrid;
+    clustering->windowGrid = &windowGrid;
+    clustering->frameArena = frameArena;
 
-    //foregroundDetector->minBlobSize = minSize * minSize;
+    foregroundDetector->minBlobSize = minSize * minSize;
+    foregroundDetector->windowGrid = &windowGrid;
 
-    //foregroundDetector->detectionResult = detectionResult;
+    foregroundDetector->detectionResult = detectionResult;
     varianceFilter->detectionResult = detectionResult;
     ensembleClassifier->detectionResult = detectionResult;
     nnClassifier->detectionResult = detectionResult;
@@ -131,7 +139,7 @@ void CuDetectorCascade::release()
 
     initialised = false;
 
-    //foregroundDetector->release();
+    foregroundDetector->release();
     ensembleClassifier->release();
     nnClassifier->release();
 
@@ -142,10 +150,7 @@ void CuDetectorCascade::release()
 
     delete[] scales;
     scales = NULL;
-    delete[] windows;
-    windows = NULL;
-    delete[] windowOffsets;
-    windowOffsets = NULL;
+    windowGrid.release();
     delete[] qualifiedWins;
     qualifiedWins = NULL;
 
@@ -163,10 +168,10 @@ void CuDetectorCascade::cleanPreviousData()
     detectionResult->reset();
 }
 
-/* returns number of bounding boxes, bounding boxes, number of scales, scales
- * bounding boxes are stored in an array of size 5*numBBs using the format <x y w h scaleIndex>
- * scales are stored using the format <w h>
- *
+/* Lays out the windows of every scale on a grid (see WindowGrid) and returns
+ * the number of scales and the scales in the format <w h>. The kernels read
+ * the windows in the format <x y w h scaleIndex>, so they are materialized on
+ * the device only.
  */
 void CuDetectorCascade::initWindowsAndScales()
 {
@@ -176,11 +181,12 @@ void CuDetectorCascade::initWindowsAndScales()
     int scanAreaW = imgWidth - 1;
     int scanAreaH = imgHeight - 1;
 
-    int windowIndex = 0;
-
     scales = new Size[maxScale - minScale + 1];
 
-    numWindows = 0;
+    windowGrid.release();
+    windowGrid.originX = scanAreaX;
+    windowGrid.originY = scanAreaY;
+    windowGrid.imgWidthStep = imgWidthStep;
 
     int scaleIndex = 0;
 
@@ -209,43 +215,17 @@ void CuDetectorCascade::initWindowsAndScales()
 
         scaleIndex++;
 
-        numWindows += floor((float)(scanAreaW - w + ssw) / ssw) * floor((float)(scanAreaH - h + ssh) / ssh);
+        windowGrid.addScale(w, h, ssw, ssh, scanAreaW, scanAreaH);
     }
 
     numScales = scaleIndex;
+    numWindows = windowGrid.numWindows;
 
-    windows = new int[TLD_WINDOW_SIZE * numWindows];
+    int *windows = new int[TLD_WINDOW_SIZE * numWindows];
 
-    for(scaleIndex = 0; scaleIndex < numScales; scaleIndex++)
+    for(int i = 0; i < numWindows; i++)
     {
-        int w = scales[scaleIndex].width;
-        int h = scales[scaleIndex].height;
-
-        int ssw, ssh;
-
-        if(useShift)
-        {
-            ssw = max<float>(1, w * shift);
-            ssh = max<float>(1, h * shift);
-        }
-        else
-        {
-            ssw = 1;
-            ssh = 1;
-        }
-
-        for(int y = scanAreaY; y + h <= scanAreaY + scanAreaH; y += ssh)
-        {
-            for(int x = scanAreaX; x + w <= scanAreaX + scanAreaW; x += ssw)
-            {
-                int *bb = &windows[TLD_WINDOW_SIZE * windowIndex];
-                tldCopyBoundaryToArray<int>(x, y, w, h, bb);
-                bb[4] = scaleIndex;
-
-                windowIndex++;
-            }
-        }
-
+        windowGrid.window(i, &windows[TLD_WINDOW_SIZE * i]);
     }
 
     cudaMalloc((void **) &windows_d, TLD_WINDOW_SIZE * numWindows * sizeof(int));
@@ -253,31 +233,7 @@ void CuDetectorCascade::initWindowsAndScales()
     cudaMalloc((void **) &d_inWinIndices, numWindows * sizeof(int));
     qualifiedWins = new int[numWindows];
 
-    assert(windowIndex == numWindows);
-}
-
-//Creates offsets that can be added to bounding boxes
-//offsets are contained in the form delta11, delta12,... (combined index of dw and dh)
-//Order: scale->tree->feature
-void CuDetectorCascade::initWindowOffsets()
-{
-
-    windowOffsets = new int[TLD_WINDOW_OFFSET_SIZE * numWindows];
-    int *off = windowOffsets;
-
-    int windowSize = TLD_WINDOW_SIZE;
-
-    for(int i = 0; i < numWindows; i++)
-    {
-
-        int *window = windows + windowSize * i;
-        *off++ = sub2idx(window[0] - 1, window[1] - 1, imgWidthStep); // x1-1,y1-1
-        *off++ = sub2idx(window[0] - 1, window[1] + window[3] - 1, imgWidthStep); // x1-1,y2
-        *off++ = sub2idx(window[0] + window[2] - 1, window[1] - 1, imgWidthStep); // x2,y1-1
-        *off++ = sub2idx(window[0] + window[2] - 1, window[1] + window[3] - 1, imgWidthStep); // x2,y2
-        *off++ = window[4] * 2 * numFeatures * numTrees; // pointer to features for this scale
-        *off++ = window[2] * window[3]; //Area of bounding box
-    }
+    delete[] windows;
 }
 
 void CuDetectorCascade::detect(const Mat &img)
@@ -287,20 +243,26 @@ void CuDetectorCascade::detect(const Mat &img)
         return;
     }
 
-    tick_t procInit, procFinal;
     NNClassifier * _nnClassifier = dynamic_cast<NNClassifier *>(nnClassifier);
 
     detectionResult->reset();
 
-    getCPUTick(&procInit);
+    MetricsTimer varianceTimer(metrics, STAGE_VARIANCE);
     cv::gpu::GpuMat gpuImg(img);    
     createIndexArray(d_inWinIndices, numWindows);
 
     int numInWins = numWindows;
     dynamic_cast<CuVarianceFilter *>(varianceFilter)->filter(gpuImg, d_inWinIndices, numInWins);
+    varianceTimer.stop();
+    int numVariancePassed = numInWins;
+
+    MetricsTimer ensembleTimer(metrics, STAGE_ENSEMBLE);
     dynamic_cast<CuEnsembleClassifier *>(ensembleClassifier)->filter(gpuImg, d_inWinIndices, numInWins);    
 
     cudaMemcpy(qualifiedWins, d_inWinIndices, numInWins * sizeof(int), cudaMemcpyDeviceToHost);
+    ensembleTimer.stop();
+
+    MetricsTimer nnTimer(metrics, STAGE_NN);
 
     for(int i = 0; i < numInWins; i++)
     {
@@ -313,11 +275,21 @@ void CuDetectorCascade::detect(const Mat &img)
         detectionResult->confidentIndices->push_back(winIdx);
     }
 
-    getCPUTick(&procFinal);
-    PRINT_TIMING("ClsfyTime", procInit, procFinal, ", ");
+    nnTimer.stop();
 
     //Cluster
+    MetricsTimer clusteringTimer(metrics, STAGE_CLUSTERING);
     clustering->clusterConfidentIndices();
+    clusteringTimer.stop();
+
+    if(metrics != NULL)
+    {
+        metrics->addCount(COUNT_WINDOWS, numWindows);
+        metrics->addCount(COUNT_VARIANCE_PASSED, numVariancePassed);
+        metrics->addCount(COUNT_ENSEMBLE_PASSED, numInWins);
+        metrics->addCount(COUNT_NN_PASSED, detectionResult->confidentIndices->size());
+        metrics->addCount(COUNT_CLUSTERS, detectionResult->numClusters);
+    }
 
     detectionResult->containsValidData = true;
 }
@@ -46,7 +46,6 @@ public:
     ~CuDetectorCascade();
 
     void init();
-    void initWindowOffsets();
     void initWindowsAndScales();
     void propagateMembers();
     void release();
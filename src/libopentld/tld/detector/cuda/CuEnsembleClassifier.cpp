@@ -46,6 +46,9 @@ CuEnsembleClassifier::CuEnsembleClassifier()
     posteriors = NULL;
     positives = NULL;
     negatives = NULL;
+    sharedModel = false;
+    changedLeaves = NULL;
+    numUpdates = 0;
     numTrees = 10;
     numFeatures = 13;
     enabled = true;
@@ -82,16 +85,21 @@ void CuEnsembleClassifier::initGPU()
 
 void CuEnsembleClassifier::release()
 {
-    delete[] features;
+    if(!sharedModel)
+    {
+        delete[] features;
+        delete[] posteriors;
+        delete[] positives;
+        delete[] negatives;
+    }
+
+    sharedModel = false;
     features = NULL;
-    delete[] featureOffsets;
-    featureOffsets = NULL;
-    delete[] posteriors;
     posteriors = NULL;
-    delete[] positives;
     positives = NULL;
-    delete[] negatives;
     negatives = NULL;
+    delete[] featureOffsets;
+    featureOffsets = NULL;
     cudaFree(features_d);
     features_d = NULL;
 }
@@ -145,9 +153,15 @@ void CuEnsembleClassifier::filter(const GpuMat &img, int *d_inWinIndices, int &n
 
 void CuEnsembleClassifier::updatePosterior(int treeIdx, int idx, int positive, int amount)
 {
+    numUpdates++;
     int arrayIndex = treeIdx * numIndices + idx;
     (positive) ? positives[arrayIndex] += amount : negatives[arrayIndex] += amount;
     posteriors[arrayIndex] = ((float) positives[arrayIndex]) / (positives[arrayIndex] + negatives[arrayIndex]) / 10.0;
+
+    if(changedLeaves != NULL)
+    {
+        changedLeaves->push_back(arrayIndex);
+    }
 }
 
 void CuEnsembleClassifier::learn(int *boundary, int positive, int *featureVector)
@@ -42,6 +42,7 @@ namespace cuda
 CuVarianceFilter::CuVarianceFilter()
 {
     windows_d = NULL;
+    hugePages = HUGE_PAGES_OFF;
 }
 
 CuVarianceFilter::~CuVarianceFilter()
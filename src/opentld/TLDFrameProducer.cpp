@@ -0,0 +1,182 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * TLDFrameProducer.cpp
+ *
+ * Publishes the frames of any input method into a shared-memory FrameRing,
+ * from which opentld instances read them with the input method SHM.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "FrameRing.h"
+#include "ImAcq.h"
+
+static char help_text[] =
+    "usage: tldframeproducer [-d <device>] [-i <path>] [-n <number>] [-s <slots>] [-g] [-f <fps>] <name>\n"
+    "Publishes frames into the shared-memory ring <name> (e.g. /tld-cam0) until the input ends.\n"
+    "[-d <device>] input method: CAM (default), VID, IMGS, RAW or PIPE\n"
+    "[-i <path>] path of the video, images or raw file\n"
+    "[-n <number>] camera device to use\n"
+    "[-s <slots>] number of frames in the ring (default 8)\n"
+    "[-g] publish greyscale frames instead of the frames as captured\n"
+    "[-f <fps>] publish at most <fps> frames per second (default: as fast as possible)\n";
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int)
+{
+    stopRequested = 1;
+}
+
+static int64_t nowMicroseconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+int main(int argc, char **argv)
+{
+    ImAcq *imAcq = imAcqAlloc();
+    imAcq->method = IMACQ_CAM;
+    int numSlots = 8;
+    bool grey = false;
+    float fps = 0;
+
+    int c;
+
+    while((c = getopt(argc, argv, "d:i:n:s:gf:h")) != -1)
+    {
+        switch(c)
+        {
+        case 'd':
+            if(!strcmp(optarg, "CAM")) imAcq->method = IMACQ_CAM;
+            else if(!strcmp(optarg, "VID")) imAcq->method = IMACQ_VID;
+            else if(!strcmp(optarg, "IMGS")) imAcq->method = IMACQ_IMGS;
+            else if(!strcmp(optarg, "RAW")) imAcq->method = IMACQ_RAW;
+            else if(!strcmp(optarg, "PIPE")) imAcq->method = IMACQ_PIPE;
+            else
+            {
+                printf("Error: Unknown input method %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+
+            break;
+        case 'i':
+            imAcq->imgPath = optarg;
+            break;
+        case 'n':
+            imAcq->camNo = atoi(optarg);
+            break;
+        case 's':
+            numSlots = atoi(optarg);
+            break;
+        case 'g':
+            grey = true;
+            break;
+        case 'f':
+            fps = atof(optarg);
+            break;
+        default:
+            printf("%s", help_text);
+            return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if(argc - optind != 1)
+    {
+        printf("%s", help_text);
+        return EXIT_FAILURE;
+    }
+
+    const char *name = argv[optind];
+
+    imAcqInit(imAcq);
+
+    IplImage *img = imAcqGetImg(imAcq);
+
+    if(img == NULL)
+    {
+        printf("Error: No frame\n");
+        return EXIT_FAILURE;
+    }
+
+    int channels = grey ? 1 : img->nChannels;
+    FrameRing *ring = frameRingCreate(name, img->width, img->height, channels, numSlots);
+
+    if(ring == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    printf("Publishing %dx%dx%d frames to %s\n", img->width, img->height, channels, name);
+
+    int64_t interval = (fps > 0) ? (int64_t)(1000000 / fps) : 0;
+    int64_t next = nowMicroseconds();
+    int numFrames = 0;
+
+    while(img != NULL && !stopRequested)
+    {
+        IplImage *frame = grey ? imAcqGetGrey(imAcq, img) : img;
+        int rowSize = frame->width * frame->nChannels;
+        char *data = frameRingBeginWrite(ring);
+
+        for(int y = 0; y < frame->height; y++)
+        {
+            memcpy(data + y * ring->header->step, frame->imageData + y * frame->widthStep, rowSize);
+        }
+
+        frameRingPublish(ring, nowMicroseconds());
+        numFrames++;
+
+        imAcqReleaseImg(imAcq, &img);
+
+        if(interval > 0)
+        {
+            next += interval;
+            int64_t wait = next - nowMicroseconds();
+
+            if(wait > 0) usleep(wait);
+        }
+
+        if(!imAcqHasMoreFrames(imAcq)) break;
+
+        img = imAcqGetImg(imAcq);
+    }
+
+    imAcqReleaseImg(imAcq, &img);
+    printf("Published %d frames\n", numFrames);
+
+    frameRingShutdown(ring);
+    //Consumers still attached keep their mapping; the name is removed
+    frameRingClose(ring);
+    imAcqFree(imAcq);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * TLDModelConv.cpp
+ *
+ * Converts models between the text format and the binary format.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ModelFile.h"
+#include "TLD.h"
+
+using namespace tld;
+
+static char help_text[] =
+    "usage: tldmodelconv [-b|-t] <input> <output>\n"
+    "Converts a model from the text format to the binary format or vice versa.\n"
+    "The format of <input> is detected automatically, by default the other\n"
+    "format is written.\n"
+    "[-b] write the binary format\n"
+    "[-t] write the text format\n";
+
+int main(int argc, char **argv)
+{
+    int argIndex = 1;
+    int outputFormat = -1; //-1: opposite of input, 0: text, 1: binary
+
+    if(argc > argIndex && strcmp(argv[argIndex], "-b") == 0)
+    {
+        outputFormat = 1;
+        argIndex++;
+    }
+    else if(argc > argIndex && strcmp(argv[argIndex], "-t") == 0)
+    {
+        outputFormat = 0;
+        argIndex++;
+    }
+
+    if(argc - argIndex != 2)
+    {
+        printf("%s", help_text);
+        return EXIT_FAILURE;
+    }
+
+    const char *input = argv[argIndex];
+    const char *output = argv[argIndex + 1];
+
+    if(outputFormat == -1)
+    {
+        outputFormat = tldModelIsBinary(input) ? 0 : 1;
+    }
+
+    TLD tld;
+    tld.readFromFile(input);
+
+    if(outputFormat == 1)
+    {
+        tld.writeToBinaryFile(output);
+    }
+    else
+    {
+        tld.writeToFile(output);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -32,10 +32,13 @@ static char help_text[] =
     "[-a <startFrameNumber>] video starts at the frameNumber <startFrameNumber>\n"
     "[-b <x,y,w,h>] Initial bounding box\n"
     "[-c] shows color images instead of greyscale\n"
-    "[-d <device>] select input device: <device>=(IMGS|CAM|VID)\n"
+    "[-d <device>] select input device: <device>=(IMGS|CAM|VID|RAW|PIPE|SHM)\n"
     "    IMGS: capture from images\n"
     "    CAM: capture from connected camera\n"
     "    VID: capture from a video\n"
+    "    RAW: read a raw greyscale or Y4M file\n"
+    "    PIPE: read raw frames from stdin or the named pipe <path>\n"
+    "    SHM: read frames from the shared-memory ring <path> of tldframeproducer\n"
     "[-e <path>] export model after run to <path>\n"
     "[-f] shows foreground\n"
     "[-i <path>] <path> to the images or to the video\n"
@@ -122,6 +125,21 @@ int Config::init(int argc, char **argv)
                 m_settings.m_method = IMACQ_IMGS;
                 m_methodSet = true;
             }
+            else if(!strcmp(optarg, "RAW"))
+            {
+                m_settings.m_method = IMACQ_RAW;
+                m_methodSet = true;
+            }
+            else if(!strcmp(optarg, "PIPE"))
+            {
+                m_settings.m_method = IMACQ_PIPE;
+                m_methodSet = true;
+            }
+            else if(!strcmp(optarg, "SHM"))
+            {
+                m_settings.m_method = IMACQ_SHM;
+                m_methodSet = true;
+            }
             else if(!strcmp(optarg, "FILE"))
             {
                 printf("OK, FILE");
@@ -182,9 +200,10 @@ int Config::init(int argc, char **argv)
         }
     }
 
-    if(!m_imagePathSet && m_methodSet && (m_settings.m_method == IMACQ_VID || m_settings.m_method == IMACQ_IMGS))
+    if(!m_imagePathSet && m_methodSet && (m_settings.m_method == IMACQ_VID || m_settings.m_method == IMACQ_IMGS || m_settings.m_method == IMACQ_RAW
+            || m_settings.m_method == IMACQ_SHM))
     {
-        cerr <<  "Error: Must set imagePath and method if capturing from images or a video." << endl;
+        cerr <<  "Error: Must set imagePath and method if capturing from images, a video or a raw file." << endl;
         return PROGRAM_EXIT;
     }
 
@@ -244,6 +263,34 @@ int Config::init(int argc, char **argv)
                 return PROGRAM_EXIT;
             }
         }
+        else if(method.compare("RAW") == 0)
+        {
+            m_settings.m_method = IMACQ_RAW;
+
+            try
+            {
+                m_cfg.lookupValue("acq.imgPath", m_settings.m_imagePath);
+            }
+            catch(const libconfig::SettingNotFoundException &nfex)
+            {
+                cerr << "Error: Unable to read image path." << endl;
+                return PROGRAM_EXIT;
+            }
+        }
+        else if(method.compare("SHM") == 0)
+        {
+            m_settings.m_method = IMACQ_SHM;
+
+            if(!m_imagePathSet)
+                m_cfg.lookupValue("acq.imgPath", m_settings.m_imagePath);
+        }
+        else if(method.compare("PIPE") == 0)
+        {
+            m_settings.m_method = IMACQ_PIPE;
+
+            if(!m_imagePathSet && m_cfg.lookupValue("acq.imgPath", m_settings.m_imagePath))
+                m_imagePathSet = true;
+        }
         else if(method.compare("CAM") == 0)
         {
             m_settings.m_method = IMACQ_CAM;
@@ -275,6 +322,34 @@ int Config::init(int argc, char **argv)
         if(!m_lastFrameSet)
             m_cfg.lookupValue("acq.lastFrame", m_settings.m_lastFrame);
 
+        // width, height
+        m_cfg.lookupValue("acq.width", m_settings.m_width);
+        m_cfg.lookupValue("acq.height", m_settings.m_height);
+
+        // format
+        string format;
+
+        if(m_cfg.lookupValue("acq.format", format))
+        {
+            if(format.compare("GREY") == 0)
+            {
+                m_settings.m_channels = 1;
+            }
+            else if(format.compare("BGR") == 0)
+            {
+                m_settings.m_channels = 3;
+            }
+            else
+            {
+                cerr << "Error: acq.format must be GREY or BGR." << endl;
+                return PROGRAM_EXIT;
+            }
+        }
+
+        // decoderThreads, readAhead
+        m_cfg.lookupValue("acq.decoderThreads", m_settings.m_decoderThreads);
+        m_cfg.lookupValue("acq.readAhead", m_settings.m_readAhead);
+
         // camNo
         if(!m_camNoSet)
             m_cfg.lookupValue("acq.camNo", m_settings.m_camNo);
@@ -287,6 +362,9 @@ int Config::init(int argc, char **argv)
         if(!m_modelPathSet)
             m_cfg.lookupValue("modelPath", m_settings.m_modelPath);
 
+        // shareModel
+        m_cfg.lookupValue("shareModel", m_settings.m_shareModel);
+
         // check if loadModel and modelPath are set, if one of them is set
         if(!m_modelPathSet)
             if(m_settings.m_loadModel && m_settings.m_modelPath.empty())
@@ -310,6 +388,28 @@ int Config::init(int argc, char **argv)
         // minSize
         m_cfg.lookupValue("detector.minSize", m_settings.m_minSize);
 
+        // background, foregroundThreshold
+        m_cfg.lookupValue("detector.background", m_settings.m_backgroundPath);
+        m_cfg.lookupValue("detector.foregroundThreshold", m_settings.m_foregroundThreshold);
+
+        // backgroundModel, backgroundFrames
+        string backgroundModel;
+
+        if(m_cfg.lookupValue("detector.backgroundModel", backgroundModel))
+            m_settings.m_backgroundAverage = (backgroundModel.compare("AVERAGE") == 0);
+
+        m_cfg.lookupValue("detector.backgroundFrames", m_settings.m_backgroundFrames);
+
+        // reuseUnchanged, changeThreshold
+        m_cfg.lookupValue("detector.reuseUnchanged", m_settings.m_reuseUnchanged);
+        m_cfg.lookupValue("detector.changeThreshold", m_settings.m_changeThreshold);
+
+        // coarseStep
+        m_cfg.lookupValue("detector.coarseStep", m_settings.m_coarseStep);
+
+        // hugePages
+        m_cfg.lookupValue("detector.hugePages", m_settings.m_hugePages);
+
         // numTrees
         m_cfg.lookupValue("detector.numTrees", m_settings.m_numTrees);
 
@@ -343,6 +443,9 @@ int Config::init(int argc, char **argv)
         // printTiming
         m_cfg.lookupValue("printTiming", m_settings.m_printTiming);
 
+        // hardwareCounters
+        m_cfg.lookupValue("hardwareCounters", m_settings.m_hardwareCounters);
+
         // learningEnabled
         m_cfg.lookupValue("learningEnabled", m_settings.m_learningEnabled);
 
@@ -365,6 +468,10 @@ int Config::init(int argc, char **argv)
         // saveDir
         m_cfg.lookupValue("saveDir", m_settings.m_outputDir);
 
+        // outputThreads, outputQueueSize
+        m_cfg.lookupValue("outputThreads", m_settings.m_outputThreads);
+        m_cfg.lookupValue("outputQueueSize", m_settings.m_outputQueueSize);
+
         // theta
         if(!m_thetaSet)
             m_cfg.lookupValue("threshold", m_settings.m_threshold);
@@ -390,9 +497,32 @@ int Config::init(int argc, char **argv)
         if(!m_exportModelAfterRunSet)
             m_cfg.lookupValue("exportModelAfterRun", m_settings.m_exportModelAfterRun);
 
+        // modelExportFormat
+        string modelExportFormat;
+
+        if(m_cfg.lookupValue("modelExportFormat", modelExportFormat))
+        {
+            m_settings.m_exportModelBinary = (modelExportFormat.compare("BINARY") == 0);
+
+            if(!m_settings.m_exportModelBinary && modelExportFormat.compare("TEXT") != 0)
+            {
+                cerr << "Warning: Unknown modelExportFormat " << modelExportFormat << ", using TEXT" << endl;
+            }
+        }
+
         // seed
         m_cfg.lookupValue("seed", m_settings.m_seed);
 
+        // trace
+        m_cfg.lookupValue("trace.path", m_settings.m_tracePath);
+        m_cfg.lookupValue("trace.firstFrame", m_settings.m_traceFirstFrame);
+        m_cfg.lookupValue("trace.lastFrame", m_settings.m_traceLastFrame);
+
+        // checkpoint
+        m_cfg.lookupValue("checkpoint.path", m_settings.m_checkpointPath);
+        m_cfg.lookupValue("checkpoint.compactSize", m_settings.m_checkpointCompactSize);
+        m_cfg.lookupValue("checkpoint.sync", m_settings.m_checkpointSync);
+
         // initialBoundingBox
         try
         {
@@ -409,6 +539,10 @@ int Config::init(int argc, char **argv)
         }
     }
 
+    // Without a path, PIPE reads stdin instead of the built-in default path
+    if(m_settings.m_method == IMACQ_PIPE && !m_imagePathSet)
+        m_settings.m_imagePath = "-";
+
     return SUCCESS;
 }
 
@@ -423,6 +557,11 @@ int Config::configure(Main *main)
     imAcq->currentFrame = m_settings.m_startFrame;
     imAcq->camNo = m_settings.m_camNo;
     imAcq->fps = m_settings.m_fps;
+    imAcq->width = m_settings.m_width;
+    imAcq->height = m_settings.m_height;
+    imAcq->channels = m_settings.m_channels;
+    imAcq->decoderThreads = m_settings.m_decoderThreads;
+    imAcq->readAhead = m_settings.m_readAhead;
 
     // main
     main->tld->trackerEnabled = m_settings.m_trackerEnabled;
@@ -430,18 +569,31 @@ int Config::configure(Main *main)
 	main->showTrajectory = (m_settings.m_trajectory) ? true : false;
 	main->trajectoryLength = m_settings.m_trajectory;
     main->printResults = (m_settings.m_printResults.empty()) ? NULL : m_settings.m_printResults.c_str();
+    main->printTiming = (m_settings.m_printTiming.empty()) ? NULL : m_settings.m_printTiming.c_str();
     main->saveDir = (m_settings.m_outputDir.empty()) ? NULL : m_settings.m_outputDir.c_str();
+    main->outputThreads = m_settings.m_outputThreads;
+    main->outputQueueSize = m_settings.m_outputQueueSize;
     main->threshold = m_settings.m_threshold;
     main->showForeground = m_settings.m_showForeground;
+    main->backgroundPath = (m_settings.m_backgroundPath.empty()) ? NULL : m_settings.m_backgroundPath.c_str();
     main->showNotConfident = m_settings.m_showNotConfident;
     main->tld->alternating = m_settings.m_alternating;
     main->tld->learningEnabled = m_settings.m_learningEnabled;
+    main->tld->metrics->hardwareCounters = m_settings.m_hardwareCounters;
     main->selectManually = m_settings.m_selectManually;
     main->exportModelAfterRun = m_settings.m_exportModelAfterRun;
     main->modelExportFile = m_settings.m_modelExportFile.c_str();
+    main->exportModelBinary = m_settings.m_exportModelBinary;
     main->loadModel = m_settings.m_loadModel;
     main->modelPath = (m_settings.m_modelPath.empty()) ? NULL : m_settings.m_modelPath.c_str();
+    main->tld->shareModel = m_settings.m_shareModel;
     main->seed = m_settings.m_seed;
+    main->tracePath = (m_settings.m_tracePath.empty()) ? NULL : m_settings.m_tracePath.c_str();
+    main->traceFirstFrame = m_settings.m_traceFirstFrame;
+    main->traceLastFrame = m_settings.m_traceLastFrame;
+    main->checkpointPath = (m_settings.m_checkpointPath.empty()) ? NULL : m_settings.m_checkpointPath.c_str();
+    main->checkpointCompactSize = m_settings.m_checkpointCompactSize;
+    main->checkpointSync = m_settings.m_checkpointSync;
 
     if(m_settings.m_initialBoundingBox.size() > 0)
     {
@@ -464,6 +616,31 @@ int Config::configure(Main *main)
     detectorCascade->minScale = m_settings.m_minScale;
     detectorCascade->maxScale = m_settings.m_maxScale;
     detectorCascade->minSize = m_settings.m_minSize;
+    detectorCascade->foregroundDetector->fgThreshold = m_settings.m_foregroundThreshold;
+    detectorCascade->foregroundDetector->adaptive = m_settings.m_backgroundAverage;
+
+    //The average follows the frames by a power of two
+    int adaptationShift = 0;
+
+    while(adaptationShift < 7 && (2 << adaptationShift) <= m_settings.m_backgroundFrames)
+    {
+        adaptationShift++;
+    }
+
+    detectorCascade->foregroundDetector->adaptationShift = adaptationShift;
+    detectorCascade->reuseUnchanged = m_settings.m_reuseUnchanged;
+    detectorCascade->changeThreshold = m_settings.m_changeThreshold;
+    detectorCascade->coarseStep = max(1, m_settings.m_coarseStep);
+
+    int hugePages = tldHugePageMode(m_settings.m_hugePages.c_str());
+
+    if(hugePages < 0)
+    {
+        cerr << "Warning: Unknown hugePages " << m_settings.m_hugePages << ", using OFF" << endl;
+        hugePages = HUGE_PAGES_OFF;
+    }
+
+    detectorCascade->hugePages = hugePages;
     detectorCascade->numTrees = m_settings.m_numTrees;
     detectorCascade->numFeatures = m_settings.m_numFeatures;
     detectorCascade->nnClassifier->thetaTP = m_settings.m_thetaP;
@@ -28,9 +28,10 @@
 #include "Config.h"
 #include "ImAcq.h"
 #include "Gui.h"
+#include "OutputWriter.h"
 #include "TLDUtil.h"
+#include "Trace.h"
 #include "Trajectory.h"
-#include "Timing.h"
 
 using namespace tld;
 using namespace cv;
@@ -39,10 +40,26 @@ void Main::doWork()
 {
 	Trajectory trajectory;
     IplImage *img = imAcqGetImg(imAcq);
-    Mat grey(img->height, img->width, CV_8UC1);
-    cvtColor(cv::Mat(img), grey, CV_BGR2GRAY);
+    IplImage *displayImg = NULL; //Copy of frames that must not be drawn into
+    Mat grey(imAcqGetGrey(imAcq, img));
 
-    tld->detectorCascade->setImgSize(grey.cols, grey.rows, grey.step);
+    //The detector reads TLD's own grey frames, which are continuous
+    tld->detectorCascade->setImgSize(grey.cols, grey.rows, grey.cols);
+
+    if(backgroundPath != NULL)
+    {
+        IplImage *bg = cvLoadImage(backgroundPath, CV_LOAD_IMAGE_GRAYSCALE);
+
+        if(bg == NULL)
+        {
+            printf("Error: Unable to read background image %s\n", backgroundPath);
+        }
+        else
+        {
+            tld->detectorCascade->foregroundDetector->bgImg = Mat(bg, true);
+            cvReleaseImage(&bg);
+        }
+    }
 
 #ifdef CUDA_ENABLED
     tld->learningEnabled = false;
@@ -78,17 +95,48 @@ void Main::doWork()
         initialBB[3] = box.height;
     }
 
-    FILE *resultsFile = NULL;
+    if(tracePath != NULL)
+    {
+#ifdef TRACE_ENABLED
+        TLD_TRACE_CONFIGURE(traceFirstFrame, traceLastFrame, 0);
+#else
+        printf("Warning: Built without TRACE_ENABLED, no trace is written\n");
+#endif
+    }
+
+    OutputWriter *writer = NULL;
+
+    if(printResults != NULL || saveDir != NULL)
+    {
+        writer = new OutputWriter(outputThreads, outputQueueSize);
+    }
 
     if(printResults != NULL)
     {
-        resultsFile = fopen(printResults, "w");
+        writer->openResults(printResults);
     }
 
     bool reuseFrameOnce = false;
     bool skipProcessingOnce = false;
 
-    if(loadModel && modelPath != NULL)
+    bool restored = false;
+
+    if(checkpointPath != NULL)
+    {
+        journal = new ModelJournal();
+        journal->compactSize = checkpointCompactSize;
+        journal->sync = checkpointSync;
+
+        restored = journal->restore(tld, checkpointPath);
+        journal->open(tld, checkpointPath);
+        tld->journal = journal;
+    }
+
+    if(restored)
+    {
+        reuseFrameOnce = true;
+    }
+    else if(loadModel && modelPath != NULL)
     {
         tld->readFromFile(modelPath);
         reuseFrameOnce = true;
@@ -104,9 +152,13 @@ void Main::doWork()
         reuseFrameOnce = true;
     }
 
+    if(!reuseFrameOnce)
+    {
+        imAcqReleaseImg(imAcq, &img);
+    }
+
     while(imAcqHasMoreFrames(imAcq))
     {
-        tick_t procInit, procFinal;
         double tic = cvGetTickCount();
 
 
@@ -119,32 +171,37 @@ void Main::doWork()
                 printf("current image is NULL, assuming end of input.\n");
                 break;
             }
-
-            cvtColor(cv::Mat(img), grey, CV_BGR2GRAY);
         }
 
+        TLD_TRACE_FRAME(imAcq->currentFrame - 1);
+
         if(!skipProcessingOnce)
         {
-            getCPUTick(&procInit);
-            tld->processImage(img);
-            getCPUTick(&procFinal);
-            PRINT_TIMING("FrameProcTime", procInit, procFinal, "\n");
+            //A single conversion, straight from the input into the buffer
+            //the tracker keeps
+            Mat frame = tld->convertToGrey(Mat(img));
+
+            if(!imAcqFrameIsValid(imAcq))
+            {
+                //The producer overwrote the frame while it was converted
+                imAcqReleaseImg(imAcq, &img);
+                reuseFrameOnce = false;
+                continue;
+            }
+
+            tld->processImage(frame);
         }
         else
         {
             skipProcessingOnce = false;
         }
 
+        //The grey frame the tracker and the detector have read
+        grey = tld->currImg;
+
         if(printResults != NULL)
         {
-            if(tld->currBB != NULL)
-            {
-                fprintf(resultsFile, "%d %.2d %.2d %.2d %.2d %f\n", imAcq->currentFrame - 1, tld->currBB->x, tld->currBB->y, tld->currBB->width, tld->currBB->height, tld->currConf);
-            }
-            else
-            {
-                fprintf(resultsFile, "%d NaN NaN NaN NaN NaN\n", imAcq->currentFrame - 1);
-            }
+            writer->addResult(imAcq->currentFrame - 1, tld->currBB, tld->currConf);
         }
 
         double toc = (cvGetTickCount() - tic) / cvGetTickFrequency();
@@ -157,6 +214,24 @@ void Main::doWork()
 
         if(showOutput || saveDir != NULL)
         {
+            IplImage *display = img;
+
+            //Overlays go to a copy if the frame is viewed in place from the
+            //input
+            if(img == imAcq->borrowed)
+            {
+                if(displayImg == NULL || displayImg->width != img->width || displayImg->height != img->height
+                        || displayImg->nChannels != img->nChannels)
+                {
+                    if(displayImg != NULL) cvReleaseImage(&displayImg);
+
+                    displayImg = cvCreateImage(cvGetSize(img), img->depth, img->nChannels);
+                }
+
+                cvCopy(img, displayImg);
+                display = displayImg;
+            }
+
             char string[128];
 
             char learningString[10] = "";
@@ -175,13 +250,13 @@ void Main::doWork()
             if(tld->currBB != NULL)
             {
                 CvScalar rectangleColor = (confident) ? blue : yellow;
-                cvRectangle(img, tld->currBB->tl(), tld->currBB->br(), rectangleColor, 8, 8, 0);
+                cvRectangle(display, tld->currBB->tl(), tld->currBB->br(), rectangleColor, 8, 8, 0);
 
 				if(showTrajectory)
 				{
 					CvPoint center = cvPoint(tld->currBB->x+tld->currBB->width/2, tld->currBB->y+tld->currBB->height/2);
-					cvLine(img, cvPoint(center.x-2, center.y-2), cvPoint(center.x+2, center.y+2), rectangleColor, 2);
-					cvLine(img, cvPoint(center.x-2, center.y+2), cvPoint(center.x+2, center.y-2), rectangleColor, 2);
+					cvLine(display, cvPoint(center.x-2, center.y-2), cvPoint(center.x+2, center.y+2), rectangleColor, 2);
+					cvLine(display, cvPoint(center.x-2, center.y+2), cvPoint(center.x+2, center.y-2), rectangleColor, 2);
 					trajectory.addPoint(center, rectangleColor);
 				}
             }
@@ -192,13 +267,13 @@ void Main::doWork()
 
 			if(showTrajectory)
 			{
-				trajectory.drawTrajectory(img);
+				trajectory.drawTrajectory(display);
 			}
 
             CvFont font;
             cvInitFont(&font, CV_FONT_HERSHEY_SIMPLEX, .5, .5, 0, 1, 8);
 //            cvRectangle(img, cvPoint(0, 0), cvPoint(img->width, 50), black, CV_FILLED, 8, 0);
-            cvPutText(img, string, cvPoint(25, 25), &font, white);
+            cvPutText(display, string, cvPoint(25, 25), &font, white);
 
             if(showForeground)
             {
@@ -206,7 +281,7 @@ void Main::doWork()
                 for(size_t i = 0; i < tld->detectorCascade->detectionResult->fgList->size(); i++)
                 {
                     Rect r = tld->detectorCascade->detectionResult->fgList->at(i);
-                    cvRectangle(img, r.tl(), r.br(), white, 1);
+                    cvRectangle(display, r.tl(), r.br(), white, 1);
                 }
 
             }
@@ -214,16 +289,15 @@ void Main::doWork()
 
             if(showOutput)
             {
-                CvSize size = cvSize(img->width*2,img->height*2);
-                IplImage*img2 =cvCreateImage(size,img->depth,img->nChannels);
-                cvResize(img, img2,CV_INTER_LINEAR);
+                CvSize size = cvSize(display->width*2,display->height*2);
+                IplImage*img2 =cvCreateImage(size,display->depth,display->nChannels);
+                cvResize(display, img2,CV_INTER_LINEAR);
                 gui->showImage(img2);
                 cvReleaseImage(&img2);
                 char key = gui->getKey();
 
                 if(key == 'q') break;
 
-                /*
                 if(key == 'b')
                 {
 
@@ -238,7 +312,6 @@ void Main::doWork()
                         fg->bgImg.release();
                     }
                 }
-                */
 
                 if(key == 'c')
                 {
@@ -260,7 +333,12 @@ void Main::doWork()
 
                 if(key == 'e')
                 {
-                    tld->writeToFile(modelExportFile);
+                    exportModel();
+                }
+
+                if(key == 't' && printTiming != NULL)
+                {
+                    tld->metrics->dump(printTiming);
                 }
 
                 if(key == 'i')
@@ -272,7 +350,7 @@ void Main::doWork()
                 {
                     CvRect box;
 
-                    if(getBBFromUser(img, box, gui) == PROGRAM_EXIT)
+                    if(getBBFromUser(display, box, gui) == PROGRAM_EXIT)
                     {
                         break;
                     }
@@ -288,21 +366,51 @@ void Main::doWork()
                 char fileName[256];
                 sprintf(fileName, "%s/%.5d.png", saveDir, imAcq->currentFrame - 1);
 
-                cvSaveImage(fileName, img);
+                writer->saveImage(fileName, display);
             }
         }
 
-        if(!reuseFrameOnce)
-        {
-            cvReleaseImage(&img);
-        }
-        else
-        {
-            reuseFrameOnce = false;
-        }
+        //The first frame is also released once it has been reused
+        imAcqReleaseImg(imAcq, &img);
+        reuseFrameOnce = false;
+    }
+
+    if(displayImg != NULL) cvReleaseImage(&displayImg);
+
+    //Waits for the queued results and frames
+    delete writer;
+
+    if(journal != NULL)
+    {
+        //Flushes the remaining changes
+        tld->journal = NULL;
+        delete journal;
+        journal = NULL;
     }
 
     if(exportModelAfterRun)
+    {
+        exportModel();
+    }
+
+    if(printTiming != NULL)
+    {
+        tld->metrics->dump(printTiming);
+    }
+
+    if(tracePath != NULL)
+    {
+        TLD_TRACE_WRITE(tracePath);
+    }
+}
+
+void Main::exportModel()
+{
+    if(exportModelBinary)
+    {
+        tld->writeToBinaryFile(modelExportFile);
+    }
+    else
     {
         tld->writeToFile(modelExportFile);
     }
@@ -28,6 +28,7 @@
 #define MAIN_H_
 
 #include "TLD.h"
+#include "ModelJournal.h"
 #include "ImAcq.h"
 #include "Gui.h"
 
@@ -47,17 +48,29 @@ public:
 	bool showTrajectory;
 	int trajectoryLength;
     const char *printResults;
+    const char *printTiming;
+    const char *tracePath;
+    int traceFirstFrame;
+    int traceLastFrame;
     const char *saveDir;
+    int outputThreads;
+    int outputQueueSize;
     double threshold;
     bool showForeground;
+    const char *backgroundPath;
     bool showNotConfident;
     bool selectManually;
     int *initialBB;
     bool reinit;
     bool exportModelAfterRun;
+    bool exportModelBinary;
     bool loadModel;
     const char *modelPath;
     const char *modelExportFile;
+    const char *checkpointPath;
+    int checkpointCompactSize;
+    bool checkpointSync;
+    tld::ModelJournal *journal;
     int seed;
 
     Main()
@@ -65,9 +78,16 @@ public:
         tld = new tld::TLD();
         showOutput = 1;
         printResults = NULL;
+        printTiming = NULL;
+        tracePath = NULL;
+        traceFirstFrame = 1;
+        traceLastFrame = 0;
         saveDir = ".";
+        outputThreads = 2;
+        outputQueueSize = 8;
         threshold = 0.5;
         showForeground = 0;
+        backgroundPath = NULL;
 
 		showTrajectory = false;
 		trajectoryLength = 0;
@@ -82,17 +102,24 @@ public:
         loadModel = false;
 
         exportModelAfterRun = false;
+        exportModelBinary = false;
         modelExportFile = "model";
+        checkpointPath = NULL;
+        checkpointCompactSize = 16 * 1024 * 1024;
+        checkpointSync = false;
+        journal = NULL;
         seed = 0;
     }
 
     ~Main()
     {
+        delete journal;
         delete tld;
         imAcqFree(imAcq);
     }
 
     void doWork();
+    void exportModel();
 };
 
 #endif /* MAIN_H_ */
@@ -0,0 +1,360 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * OutputWriter.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "OutputWriter.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <stdint.h>
+
+#include <opencv/highgui.h>
+
+namespace tld
+{
+
+OutputWriter::Queue::Queue(size_t capacity) : capacity(capacity), closing(false)
+{
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&notEmpty, NULL);
+    pthread_cond_init(&notFull, NULL);
+}
+
+OutputWriter::Queue::~Queue()
+{
+    pthread_mutex_destroy(&mutex);
+    pthread_cond_destroy(&notEmpty);
+    pthread_cond_destroy(&notFull);
+}
+
+bool OutputWriter::Queue::push(const Task &task)
+{
+    bool waited = false;
+
+    pthread_mutex_lock(&mutex);
+
+    while(tasks.size() >= capacity)
+    {
+        waited = true;
+        pthread_cond_wait(&notFull, &mutex);
+    }
+
+    tasks.push_back(task);
+    pthread_cond_signal(&notEmpty);
+    pthread_mutex_unlock(&mutex);
+
+    return !waited;
+}
+
+bool OutputWriter::Queue::pop(Task *task)
+{
+    pthread_mutex_lock(&mutex);
+
+    while(tasks.empty() && !closing)
+    {
+        pthread_cond_wait(&notEmpty, &mutex);
+    }
+
+    bool ok = !tasks.empty();
+
+    if(ok)
+    {
+        *task = tasks.front();
+        tasks.pop_front();
+        pthread_cond_signal(&notFull);
+    }
+
+    pthread_mutex_unlock(&mutex);
+    return ok;
+}
+
+void OutputWriter::Queue::close()
+{
+    pthread_mutex_lock(&mutex);
+    closing = true;
+    pthread_cond_broadcast(&notEmpty);
+    pthread_mutex_unlock(&mutex);
+}
+
+OutputWriter::OutputWriter(int numThreads, int queueSize) :
+    frames(queueSize > 0 ? queueSize : 1),
+    results(16),
+    hasResultsThread(false),
+    resultsFile(NULL),
+    resultsFormat(RESULTS_TEXT),
+    pendingResults(new std::string()),
+    batchSize(64 * 1024),
+    numStalls(0)
+{
+    pthread_mutex_init(&buffersMutex, NULL);
+
+    if(numThreads < 1) numThreads = 1;
+
+    for(int i = 0; i < numThreads; i++)
+    {
+        pthread_t thread;
+
+        if(pthread_create(&thread, NULL, runEncoder, this) == 0)
+        {
+            threads.push_back(thread);
+        }
+    }
+
+    if(threads.empty())
+    {
+        printf("Error: Unable to start output threads\n");
+    }
+}
+
+OutputWriter::~OutputWriter()
+{
+    close();
+    delete pendingResults;
+    pthread_mutex_destroy(&buffersMutex);
+}
+
+void *OutputWriter::runEncoder(void *arg)
+{
+    OutputWriter *writer = (OutputWriter *) arg;
+    Task task;
+
+    while(writer->frames.pop(&task))
+    {
+        if(!cvSaveImage(task.path.c_str(), task.img))
+        {
+            printf("Error: Unable to write %s\n", task.path.c_str());
+        }
+
+        writer->releaseBuffer(task.img);
+    }
+
+    return NULL;
+}
+
+void *OutputWriter::runResults(void *arg)
+{
+    OutputWriter *writer = (OutputWriter *) arg;
+    Task task;
+
+    while(writer->results.pop(&task))
+    {
+        fwrite(task.bytes->data(), 1, task.bytes->size(), writer->resultsFile);
+        fflush(writer->resultsFile);
+        delete task.bytes;
+    }
+
+    return NULL;
+}
+
+IplImage *OutputWriter::acquireBuffer(const IplImage *img)
+{
+    IplImage *buffer = NULL;
+
+    pthread_mutex_lock(&buffersMutex);
+
+    for(size_t i = 0; i < freeBuffers.size(); i++)
+    {
+        IplImage *candidate = freeBuffers[i];
+
+        if(candidate->width == img->width && candidate->height == img->height
+                && candidate->depth == img->depth && candidate->nChannels == img->nChannels)
+        {
+            buffer = candidate;
+            freeBuffers.erase(freeBuffers.begin() + i);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&buffersMutex);
+
+    if(buffer == NULL)
+    {
+        buffer = cvCreateImage(cvGetSize(img), img->depth, img->nChannels);
+    }
+
+    buffer->origin = img->origin;
+    return buffer;
+}
+
+void OutputWriter::releaseBuffer(IplImage *img)
+{
+    pthread_mutex_lock(&buffersMutex);
+    freeBuffers.push_back(img);
+    pthread_mutex_unlock(&buffersMutex);
+}
+
+bool OutputWriter::openResults(const char *path)
+{
+    size_t len = strlen(path);
+    bool binary = len >= 4 && strcmp(path + len - 4, ".bin") == 0;
+
+    resultsFile = fopen(path, binary ? "wb" : "w");
+
+    if(resultsFile == NULL)
+    {
+        printf("Error: Unable to write results to %s\n", path);
+        return false;
+    }
+
+    if(binary)
+    {
+        resultsFormat = RESULTS_BINARY;
+    }
+    else if(len >= 4 && strcmp(path + len - 4, ".csv") == 0)
+    {
+        resultsFormat = RESULTS_CSV;
+        pendingResults->append("frame,x,y,width,height,confidence\n");
+    }
+
+    hasResultsThread = pthread_create(&resultsThread, NULL, runResults, this) == 0;
+    return true;
+}
+
+void OutputWriter::addResult(int frame, const cv::Rect *bb, float conf)
+{
+    if(resultsFile == NULL) return;
+
+    if(resultsFormat == RESULTS_BINARY)
+    {
+        int32_t record[6] = {frame, 0, 0, 0, 0, 0};
+        float value = (bb != NULL) ? conf : NAN;
+
+        if(bb != NULL)
+        {
+            record[1] = bb->x;
+            record[2] = bb->y;
+            record[3] = bb->width;
+            record[4] = bb->height;
+        }
+
+        memcpy(&record[5], &value, sizeof(float));
+        pendingResults->append((const char *) record, sizeof(record));
+    }
+    else
+    {
+        char line[128];
+
+        if(resultsFormat == RESULTS_CSV)
+        {
+            if(bb != NULL) sprintf(line, "%d,%d,%d,%d,%d,%f\n", frame, bb->x, bb->y, bb->width, bb->height, conf);
+            else sprintf(line, "%d,,,,,\n", frame);
+        }
+        else
+        {
+            if(bb != NULL) sprintf(line, "%d %.2d %.2d %.2d %.2d %f\n", frame, bb->x, bb->y, bb->width, bb->height, conf);
+            else sprintf(line, "%d NaN NaN NaN NaN NaN\n", frame);
+        }
+
+        pendingResults->append(line);
+    }
+
+    if(pendingResults->size() >= batchSize)
+    {
+        flushResults();
+    }
+}
+
+void OutputWriter::flushResults()
+{
+    if(pendingResults->empty()) return;
+
+    if(!hasResultsThread)
+    {
+        fwrite(pendingResults->data(), 1, pendingResults->size(), resultsFile);
+        pendingResults->clear();
+        return;
+    }
+
+    Task task;
+    task.img = NULL;
+    task.bytes = pendingResults;
+    pendingResults = new std::string();
+    pendingResults->reserve(batchSize);
+    results.push(task);
+}
+
+void OutputWriter::saveImage(const char *path, const IplImage *img)
+{
+    if(threads.empty())
+    {
+        cvSaveImage(path, img);
+        return;
+    }
+
+    Task task;
+    task.path = path;
+    task.img = acquireBuffer(img);
+    task.bytes = NULL;
+    cvCopy(img, task.img);
+
+    if(!frames.push(task))
+    {
+        numStalls++;
+    }
+}
+
+void OutputWriter::close()
+{
+    if(resultsFile != NULL)
+    {
+        flushResults();
+    }
+
+    frames.close();
+    results.close();
+
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    threads.clear();
+
+    if(hasResultsThread)
+    {
+        pthread_join(resultsThread, NULL);
+        hasResultsThread = false;
+    }
+
+    if(resultsFile != NULL)
+    {
+        fclose(resultsFile);
+        resultsFile = NULL;
+    }
+
+    for(size_t i = 0; i < freeBuffers.size(); i++)
+    {
+        cvReleaseImage(&freeBuffers[i]);
+    }
+
+    freeBuffers.clear();
+
+    if(numStalls > 0)
+    {
+        printf("Warning: Writing output frames stalled tracking %d times; consider more outputThreads\n", numStalls);
+        numStalls = 0;
+    }
+}
+
+} /* namespace tld */
@@ -0,0 +1,117 @@
+/*  Copyright 2011 AIT Austrian Institute of Technology
+*
+*   This file is part of OpenTLD.
+*
+*   OpenTLD is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   OpenTLD is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with OpenTLD.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+/*
+ * OutputWriter.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OUTPUTWRITER_H_
+#define OUTPUTWRITER_H_
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include <opencv/cv.h>
+
+namespace tld
+{
+
+/**
+ * Writes results and output frames in the background, so that neither
+ * formatting, file I/O nor image encoding happens in the tracking loop.
+ * Frames are copied into recycled buffers and encoded by a pool of threads;
+ * results are collected in memory and written in batches by a separate
+ * thread, in order. When more frames are queued than the queue holds, the
+ * caller waits (and the number of such stalls is reported).
+ */
+class OutputWriter
+{
+    struct Task
+    {
+        std::string path;
+        IplImage *img;
+        std::string *bytes;
+    };
+
+    class Queue
+    {
+        std::deque<Task> tasks;
+        size_t capacity;
+        bool closing;
+        pthread_mutex_t mutex;
+        pthread_cond_t notEmpty;
+        pthread_cond_t notFull;
+
+    public:
+        Queue(size_t capacity);
+        ~Queue();
+        bool push(const Task &task); //Returns false if it had to wait
+        bool pop(Task *task); //Returns false once closed and empty
+        void close();
+    };
+
+    enum ResultsFormat
+    {
+        RESULTS_TEXT,
+        RESULTS_CSV,
+        RESULTS_BINARY
+    };
+
+    Queue frames;
+    Queue results;
+    std::vector<pthread_t> threads;
+    bool hasResultsThread;
+    pthread_t resultsThread;
+    FILE *resultsFile;
+    int resultsFormat;
+    std::string *pendingResults;
+    size_t batchSize;
+    std::vector<IplImage *> freeBuffers;
+    pthread_mutex_t buffersMutex;
+    int numStalls;
+
+    static void *runEncoder(void *arg);
+    static void *runResults(void *arg);
+    IplImage *acquireBuffer(const IplImage *img);
+    void releaseBuffer(IplImage *img);
+    void flushResults();
+
+public:
+    OutputWriter(int numThreads, int queueSize);
+    virtual ~OutputWriter(); //Writes everything still pending
+
+    /**
+     * Results are written as CSV if path ends with .csv, as binary records
+     * (int32 frame, x, y, width, height; float confidence; width 0 and
+     * confidence NaN without a bounding box) if it ends with .bin and in the
+     * text format of opentld otherwise.
+     */
+    bool openResults(const char *path);
+    void addResult(int frame, const cv::Rect *bb, float conf);
+    void saveImage(const char *path, const IplImage *img);
+    void close();
+};
+
+} /* namespace tld */
+#endif /* OUTPUTWRITER_H_ */
@@ -35,6 +35,7 @@ Settings::Settings() :
     m_ensembleClassifierEnabled(true),
     m_nnClassifierEnabled(true),
     m_loadModel(false),
+    m_shareModel(false),
     m_trackerEnabled(true),
     m_selectManually(false),
     m_learningEnabled(true),
@@ -46,6 +47,9 @@ Settings::Settings() :
     m_saveOutput(false),
     m_alternating(false),
     m_exportModelAfterRun(false),
+    m_exportModelBinary(false),
+    m_checkpointSync(false),
+    m_hardwareCounters(false),
     m_trajectory(0),
     m_method(IMACQ_CAM),
     m_startFrame(1),
@@ -57,9 +61,26 @@ Settings::Settings() :
     m_thetaP(0.65),
     m_thetaN(0.5),
     m_minSize(25),
+    m_foregroundThreshold(16),
+    m_backgroundAverage(false),
+    m_backgroundFrames(64),
+    m_reuseUnchanged(false),
+    m_changeThreshold(0),
+    m_coarseStep(1),
+    m_hugePages("OFF"),
     m_camNo(0),
+    m_width(0),
+    m_height(0),
+    m_channels(1),
+    m_decoderThreads(4),
+    m_readAhead(16),
+    m_outputThreads(2),
+    m_outputQueueSize(8),
     m_fps(24),
     m_seed(0),
+    m_traceFirstFrame(1),
+    m_traceLastFrame(0),
+    m_checkpointCompactSize(16 * 1024 * 1024),
     m_threshold(0.7),
     m_proportionalShift(0.1),
     m_modelExportFile("model"),
@@ -49,6 +49,7 @@ public:
     bool m_nnClassifierEnabled;
     bool m_useProportionalShift; //!< sets scanwindows off by a percentage value of the window dimensions (specified in proportionalShift) rather than 1px.
     bool m_loadModel; //!< if true, model specified by "modelPath" is loaded at startup
+    bool m_shareModel; //!< if true, a binary model is mapped copy-on-write and shared instead of copied
     bool m_selectManually; //!< if true, user can select initial bounding box (which then overrides the setting "initialBoundingBox")
     bool m_learningEnabled; //!< enables learning while processing
     bool m_showOutput; //!< creates a window displaying results
@@ -59,6 +60,9 @@ public:
     bool m_saveOutput; //!< specifies whether to save visual output
     bool m_alternating; //!< if set to true, detector is disabled while tracker is running.
     bool m_exportModelAfterRun; //!< if set to true, model is exported after run.
+    bool m_exportModelBinary; //!< if set to true, model is exported in the binary format instead of text.
+    bool m_checkpointSync; //!< if set to true, every journal write is synced to disk.
+    bool m_hardwareCounters; //!< if set to true, hardware performance counters are added to the timings of every stage.
     int m_trajectory; //!< specifies the number of the last frames which are considered by the trajectory; 0 disables the trajectory
     int m_method; //!< method of capturing: IMACQ_CAM, IMACQ_IMGS or IMACQ_VID
     int m_startFrame; //!< first frame of capturing
@@ -70,16 +74,36 @@ public:
     float m_thetaP;
     float m_thetaN;
     int m_seed;
+    int m_traceFirstFrame; //!< first frame recorded into the trace
+    int m_traceLastFrame; //!< last frame recorded into the trace; 0 means all frames
+    int m_checkpointCompactSize; //!< journal size in bytes after which a new snapshot is written
     int m_minSize; //!< minimum size of scanWindows
+    int m_foregroundThreshold; //!< minimum difference to the background image of a foreground pixel
+    bool m_backgroundAverage; //!< if true, the background is a running average of the frames instead of a static image
+    int m_backgroundFrames; //!< number of frames the running average of the background extends over
+    bool m_reuseUnchanged; //!< if true, windows in unchanged parts of the image keep the outcome of the last detection
+    int m_changeThreshold; //!< largest pixel difference that counts as unchanged
+    int m_coarseStep; //!< scan every m_coarseStep-th window first and refine around its hits; 1 scans all windows
+    std::string m_hugePages; //!< page backing of the per-window arrays and integral images: OFF, TRANSPARENT or EXPLICIT
     int m_camNo; //!< Which camera to use
+    int m_width; //!< frame width of raw input without a header
+    int m_height; //!< frame height of raw input without a header
+    int m_channels; //!< 1 (GREY) or 3 (BGR) for frames read from a pipe
+    int m_decoderThreads; //!< threads decoding images ahead of time if m_method is IMACQ_IMGS; 0 decodes on demand
+    int m_readAhead; //!< maximum number of images decoded ahead
+    int m_outputThreads; //!< threads encoding the frames written to m_outputDir
+    int m_outputQueueSize; //!< frames waiting to be written before tracking waits for the output threads
     float m_fps; //!< Frames per second
     float m_threshold; //!< threshold for determining positive results
     float m_proportionalShift; //!< proportional shift
     std::string  m_imagePath; //!< path to the images or the video if m_method is IMACQ_VID or IMACQ_IMGS
     std::string m_modelPath; //!< if modelPath is not set then either an initialBoundingBox must be specified or selectManually must be true.
     std::string m_modelExportFile; //!< Path where model is saved on export.
+    std::string m_checkpointPath; //!< if set, the model is checkpointed continuously to this path and restored from it at startup
+    std::string m_backgroundPath; //!< image of the static background; if set, only windows inside the foreground are detected
     std::string m_outputDir; //!< required if saveOutput = true, no default
     std::string m_printResults; //!< path to the file were the results should be printed; NULL -> results will not be printed
+    std::string m_tracePath; //!< path to the file the Chrome trace is written to; requires building with TRACE_ENABLED
     std::string m_printTiming; //!< path to the file were the timings should be printed; NULL -> results will not be printed
     std::vector<int> m_initialBoundingBox; //!< Initial Bounding Box can be specified here
 };